@@ -2,6 +2,7 @@
 #include <iostream>
 #include <math.h>
 #include <AWML/awml.h>
+#include <AWML/event_loop.h>
 
 int main()
 {
@@ -236,24 +237,47 @@ int main()
     // VAOs requires a call to glBindVertexArray anyways so we generally don't unbind VAOs (nor VBOs) when it's not directly necessary.
     glBindVertexArray(0);
 
-    while (!window->ShouldClose())
-    {
-        static float moving_x = -1.0f;
+    auto loop = awml::EventLoop::Create();
 
-        if (moving_x - 1.0f > 1.0f)
-            moving_x = -1.0f;
+    loop->OnError(
+        [](awml::error code, const std::string& msg)
+        {
+            std::cout << "AWML LOOP ERROR: "
+                << static_cast<uint16_t>(code)
+                << " " << msg
+                << std::endl;
+        }
+    );
 
-        moving_x += 0.01f;
-        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
+    // Input is dispatched as soon as it arrives,
+    // the loop sleeps in between.
+    loop->AddWindow(*window);
 
-        // draw our first triangle
-        glUseProgram(shaderProgram);
-        glBindVertexArray(VAO); // seeing as we only have a single VAO there's no need to bind it every time, but we'll do so to keep things a bit more organized
-        glDrawArrays(GL_TRIANGLES, 0, 3);
+    // Redraw at ~60 FPS.
+    loop->AddTimer(
+        std::chrono::nanoseconds::zero(),
+        [&window, shaderProgram, VAO]()
+        {
+            static float moving_x = -1.0f;
 
-        window->Update();
-    }
+            if (moving_x - 1.0f > 1.0f)
+                moving_x = -1.0f;
+
+            moving_x += 0.01f;
+            glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT);
+
+            // draw our first triangle
+            glUseProgram(shaderProgram);
+            glBindVertexArray(VAO); // seeing as we only have a single VAO there's no need to bind it every time, but we'll do so to keep things a bit more organized
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+
+            window->SwapBuffers();
+        },
+        std::chrono::microseconds(16667)
+    );
+
+    loop->Run();
 
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
@@ -1,6 +1,9 @@
+#pragma once
+
 #include <string>
 #include <functional>
 #include <memory>
+#include <chrono>
 
 #ifdef _WIN32
   #include <windows.h>
@@ -9,6 +12,8 @@
 #include "awml_gl.h"
 
 #include "key_codes.h"
+#include "events.h"
+#include "input.h"
 
 namespace awml {
 
@@ -49,6 +54,133 @@ namespace awml {
         OpenGL = 1
     };
 
+    // Which implementation Window::Create builds.
+    enum class WindowBackend : uint8_t
+    {
+        DEFAULT  = 0, // HEADLESS if the AWML_BACKEND environment variable is "headless", NATIVE otherwise
+        NATIVE   = 1, // The platform window system
+        HEADLESS = 2  // No window system, events are injected, see GetHeadlessControl
+    };
+
+    // How fast Window::CreateReplay plays back a recorded log.
+    enum class ReplaySpeed : uint8_t
+    {
+        REAL_TIME           = 0, // Events are delivered with their recorded spacing
+        AS_FAST_AS_POSSIBLE = 1  // Every poll delivers as many events as fit the queue
+    };
+
+    // Limits of a single PollEvents(PollBudget) call, 0 means no limit.
+    struct PollBudget
+    {
+        size_t max_events = 0;
+
+        std::chrono::nanoseconds max_time = std::chrono::nanoseconds::zero();
+    };
+
+    // The default framebuffer requested for an OpenGL window. The
+    // cheapest config that has at least the requested sizes is chosen,
+    // fewer samples win first, then fewer depth/stencil and color bits,
+    // see Window::GetFramebufferConfig for the config actually chosen.
+    struct FramebufferConfig
+    {
+        uint8_t red_bits   = 8;
+        uint8_t green_bits = 8;
+        uint8_t blue_bits  = 8;
+        uint8_t alpha_bits = 8;
+
+        // 0 for no depth/stencil buffer.
+        uint8_t depth_bits   = 24;
+        uint8_t stencil_bits = 8;
+
+        // MSAA samples, 0 for no multisampling.
+        uint8_t samples = 0;
+
+        bool srgb            = false;
+        bool double_buffered = true;
+    };
+
+    enum class GLProfile : uint8_t
+    {
+        DEFAULT       = 0, // No profile requested, the driver's default
+        CORE          = 1,
+        COMPATIBILITY = 2
+    };
+
+    // What the swap interval of a context can be set to,
+    // see Window::SetSwapInterval.
+    enum class SwapControl : uint8_t
+    {
+        NONE     = 0,
+
+        INTERVAL = 1, // Vsync off (0) or every n-th refresh
+        ADAPTIVE = 2  // Negative intervals, a late frame tears instead of waiting
+    };
+
+    inline SwapControl operator|(SwapControl l, SwapControl r)
+    {
+        return static_cast<SwapControl>(
+            static_cast<uint8_t>(l) |
+            static_cast<uint8_t>(r)
+        );
+    }
+
+    inline uint8_t operator&(SwapControl l, SwapControl r)
+    {
+        return static_cast<uint8_t>(l) &
+               static_cast<uint8_t>(r);
+    }
+
+    // How closely Update kept to the rate set with
+    // Window::SetTargetFrameRate, measured between frames.
+    struct FramePacingStats
+    {
+        uint64_t frames = 0;
+
+        std::chrono::nanoseconds target          { 0 };
+        std::chrono::nanoseconds mean_frame_time { 0 };
+
+        // Standard deviation of the frame time.
+        std::chrono::nanoseconds jitter { 0 };
+
+        // Largest difference of a frame time from the target.
+        std::chrono::nanoseconds max_deviation { 0 };
+    };
+
+    // Attributes of the OpenGL context created by Launch, see
+    // Window::GetContextConfig for the ones actually obtained.
+    // Attributes the driver has no extension for are left out.
+    struct ContextConfig
+    {
+        // 0.0 leaves the version to the driver, usually its newest.
+        // With a profile it's at least 3.2, where profiles start.
+        uint8_t major = 0;
+        uint8_t minor = 0;
+
+        GLProfile profile = GLProfile::DEFAULT;
+
+        bool debug              = false;
+        bool forward_compatible = false;
+
+        // Skips the error checking in every GL call, GL errors become
+        // undefined behavior. Can't be combined with debug or robust.
+        bool no_error = false;
+
+        // Robust buffer access, a GPU reset loses the context and is
+        // reported through glGetGraphicsResetStatus.
+        bool robust = false;
+    };
+
+    // Settings of the dedicated input thread, see Window::EnableInputThread.
+    struct InputThreadConfig
+    {
+        // Scheduling priority of the input thread. 0 keeps the default
+        // policy, anything above requests a real-time (SCHED_FIFO) priority.
+        int priority = 0;
+
+        // Bitmask of the CPUs the input thread may run on, 0 means any.
+        uint64_t cpu_affinity = 0;
+    };
+
     // A callback that gets called when a key is pressed.
     // Parameters:
     // awml_key -> Key that was pressed.
@@ -108,6 +240,32 @@ namespace awml {
     typedef std::function<void(wchar_t)>
         char_typed_callback;
 
+    // A callback that gets called for every event posted with PostEvent.
+    // Parameters:
+    // uint32_t -> The application defined event code.
+    // void* -> The data posted along with it.
+    typedef std::function<void(uint32_t, void*)>
+        user_event_callback;
+
+    // A callback that draws a single frame on the render thread,
+    // see Window::StartRenderThread. SwapBuffers is called after it.
+    // Parameters:
+    // NONE
+    typedef std::function<void()>
+        render_callback;
+
+    // A callback bound to the parameters of its event,
+    // see Window::SetCallbackExecutor.
+    typedef std::function<void()>
+        callback_task;
+
+    // Runs callback tasks away from the polling thread,
+    // e.g. by posting them to a thread pool.
+    // Parameters:
+    // callback_task -> The task to run.
+    typedef std::function<void(callback_task)>
+        callback_executor;
+
 
     enum class error : uint16_t
     {
@@ -139,6 +297,12 @@ namespace awml {
 
     class Window;
 
+    // Coroutine support, see coroutine.h.
+    struct AwaitNode;
+    class FrameAwaitable;
+    class EventAwaitable;
+    class KeyAwaitable;
+
     class GraphicsContext
     {
     public:
@@ -146,6 +310,11 @@ namespace awml {
         virtual bool Activate() = 0;
         virtual void SwapBuffers() = 0;
         virtual void MakeCurrent() = 0;
+        virtual void ReleaseCurrent() = 0;
+        virtual bool SetSwapInterval(int interval) = 0;
+        virtual SwapControl GetSwapControl() = 0;
+        virtual bool SetMaxFramesInFlight(uint32_t frames) = 0;
+        virtual std::chrono::nanoseconds GetFrameWaitTime() = 0;
         virtual ~GraphicsContext() {}
     };
 
@@ -165,7 +334,18 @@ namespace awml {
             Context context = Context::NONE,
             WindowMode window_mode = WindowMode::WINDOWED,
             CursorMode cursor_mode = CursorMode::VISIBLE | CursorMode::FREE,
-            bool resizable = false
+            bool resizable = false,
+            WindowBackend backend = WindowBackend::DEFAULT,
+            const FramebufferConfig& framebuffer = FramebufferConfig(),
+            const ContextConfig& context_config = ContextConfig()
+        );
+
+        // Creates a window that plays back an event log written by
+        // StartRecording instead of talking to the window system.
+        // Launch opens the log, ShouldClose turns true at its end.
+        static SharedWindow CreateReplay(
+            const std::string& log_path,
+            ReplaySpeed speed = ReplaySpeed::REAL_TIME
         );
 
         Window(const Window& other) = delete;
@@ -179,6 +359,16 @@ namespace awml {
     public:
         virtual bool Launch() = 0;
 
+        // Reads and decodes window events on a dedicated thread
+        // that sleeps on the display connection, so input is picked
+        // up (and timestamped) as soon as it arrives instead of when
+        // the render loop gets around to polling. PollEvents, DrainEvents
+        // and WaitEvents then only consume the decoded events.
+        // Has to be called before Launch.
+        virtual bool EnableInputThread(
+            const InputThreadConfig& config = InputThreadConfig()
+        ) = 0;
+
         virtual void OnError(
             error_callback cb
         ) = 0;
@@ -219,14 +409,202 @@ namespace awml {
             char_typed_callback cb
         ) = 0;
 
+        virtual void OnUserEvent(
+            user_event_callback cb
+        ) = 0;
+
+        // Hands the callback of an event type to executor instead of
+        // calling it inline while polling, so heavy handlers (layout on
+        // resize, search on typing...) don't stall the loop, which goes
+        // on decoding. An empty executor makes the callback inline again.
+        // The tasks of one event type are handed to the executor in the
+        // order of their events, they also run in that order if the
+        // executor is serial, but not necessarily on a pool. Callbacks of
+        // different event types aren't ordered against each other, an
+        // inline callback can run before an earlier offloaded one.
+        // Tasks carry the parameters of their event, window state
+        // queried from them is that of the time they run.
+        virtual void SetCallbackExecutor(
+            EventType type,
+            callback_executor executor
+        ) = 0;
+
+        // Queues an application defined event and wakes the window up.
+        // Can be called from any thread, the events are delivered in
+        // the order they were posted through the same path as the
+        // window events. Returns false if the queue is full.
+        virtual bool PostEvent(const UserEvent& event) = 0;
+
+        // Makes a WaitEvents (or an EventLoop sleeping on the window)
+        // return, can be called from any thread.
+        virtual void Wakeup() = 0;
+
+        // Selects which event floods are merged before they are
+        // queued, Event::count tells how many raw events a merged
+        // one stands for. Nothing is coalesced by default.
+        virtual void SetEventCoalescing(Coalesce mode) = 0;
+
+        // Writes every event handed to the callbacks or queue consumers
+        // from now on to a memory mapped log at path, see CreateReplay.
+        // Logs are only readable by builds with the same Event layout.
+        // User events are left out, their data is only valid in the
+        // process that posted them.
+        virtual bool StartRecording(const std::string& path) = 0;
+
+        // Finishes the log, also done when the window is destroyed.
+        virtual void StopRecording() = 0;
+
         virtual void SetTitle(const std::wstring& title) = 0;
 
+        // Makes the graphics context current on the calling thread.
+        // A context is current on one thread at a time, so it has to
+        // be released with ReleaseCurrent before another thread can
+        // take it over. Launch leaves it current on the launching thread.
         virtual void MakeCurrent() = 0;
 
+        virtual void ReleaseCurrent() = 0;
+
+        // Takes the graphics context over to a thread of its own that
+        // calls render and SwapBuffers in a loop until StopRenderThread
+        // or until the window should close, while events keep being
+        // processed wherever the window is polled. Every window can
+        // have its own render thread, so many windows render in parallel.
+        // Returns once the context is current on the render thread, or
+        // false if another thread still has it current.
+        virtual bool StartRenderThread(render_callback render) = 0;
+
+        // Joins the render thread, the context is left released.
+        virtual void StopRenderThread() = 0;
+
+        // C++20 awaitables, defined in coroutine.h. The coroutines
+        // are resumed by the polls of the window (PollEvents, WaitEvents,
+        // DispatchPending, DrainEvents...) on the polling thread, and
+        // must not poll the window themselves.
+        FrameAwaitable NextFrame();
+        EventAwaitable NextEvent();
+        KeyAwaitable KeyDown(awml_key key);
+
+        // The hooks behind the awaitables and awml::Task,
+        // only called from the polling thread.
+        virtual void Suspend(AwaitNode& node) = 0;
+
+        virtual void* AllocateCoroutine(size_t size) = 0;
+        virtual void FreeCoroutine(void* frame, size_t size) = 0;
+
         virtual void PollEvents() = 0;
+
+        // Like PollEvents, but stops once the budget is used up and
+        // leaves the remaining events queued for the next call, so a
+        // flood of events can't blow the frame time. Key, button and
+        // other discrete events are dispatched before mouse motion
+        // that arrived ahead of them.
+        // Returns the amount of events still waiting.
+        virtual size_t PollEvents(PollBudget budget) = 0;
+
+        // Decodes the pending window events and moves up to max
+        // of them into out in the order they arrived.
+        // Returns the number of events written.
+        // Events consumed this way are not passed to the callbacks,
+        // so use either this or PollEvents/Update, not both.
+        virtual size_t DrainEvents(Event* out, size_t max) = 0;
+
+        // Declares which event types the queue consumers
+        // (DrainEvents, PollEvents(handler)) are interested in.
+        // Together with the installed callbacks this decides which
+        // events are requested from the system at all, so unused
+        // event classes never reach the process. Empty until the
+        // queue is consumed, the first DrainEvents without a
+        // SelectEvents widens it to all. PollEvents(handler)
+        // sets it to the handler's methods.
+        virtual void SelectEvents(event_mask mask) = 0;
+
+        // Drains the pending events and forwards each one directly
+        // to the matching method of handler, see DispatchEvent
+        // for the list of supported methods. The dispatch is
+        // instantiated per handler type, so it can be inlined and
+        // methods the handler doesn't have are compiled out.
+        // Like DrainEvents, this bypasses the callbacks
+        // and it replaces the SelectEvents mask.
+        template<typename Handler>
+        void PollEvents(Handler& handler)
+        {
+            SelectEvents(HandlerEventMask<Handler>());
+
+            Event batch[AWML_EVENT_BATCH_SIZE];
+
+            size_t count;
+            while ((count = DrainEvents(batch, AWML_EVENT_BATCH_SIZE)))
+            {
+                for (size_t i = 0; i < count; ++i)
+                    DispatchEvent(handler, batch[i]);
+            }
+        }
+
+        // A file descriptor that becomes readable when the window
+        // has events to process, so the window can be driven by an
+        // external event loop (epoll, io_uring...) that calls
+        // DispatchPending when it fires. On X this covers the
+        // connection and Wakeup, or the input thread's notifications
+        // if it's enabled, and stays the same while the window is open,
+        // also when a failed input thread hands polling back.
+        // -1 on platforms without one (Windows).
+        virtual int GetEventFd() = 0;
+
+        // Processes exactly the events that are already available,
+        // without blocking or flushing requests to the server, and
+        // passes them to the callbacks like PollEvents.
+        // Returns the number of events dispatched.
+        virtual size_t DispatchPending() = 0;
+
+        // Sends the requests buffered for the window system,
+        // call before sleeping on GetEventFd.
+        virtual void Flush() = 0;
+
+        // Sleeps until at least one event arrives
+        // and then processes the events like PollEvents.
+        virtual void WaitEvents() = 0;
+
+        // Same as WaitEvents but returns after the timeout
+        // even if no events have arrived.
+        virtual void WaitEventsTimeout(std::chrono::nanoseconds timeout) = 0;
+
         virtual void SwapBuffers() = 0;
         virtual void Update() = 0;
 
+        // Sets how many display refreshes SwapBuffers waits for, 0 turns
+        // vsync off. A negative interval is adaptive vsync, a frame that
+        // is on time waits for -interval refreshes while a late one is
+        // shown right away and tears instead of costing a whole refresh.
+        // Without adaptive support the absolute value is used.
+        // Returns false if the interval couldn't be set exactly.
+        // Has to be called on the thread the context is current on.
+        virtual bool SetSwapInterval(int interval) = 0;
+
+        // What SetSwapInterval supports for this window's context.
+        virtual SwapControl GetSwapControl() = 0;
+
+        // Makes Update wait so frames start at hz per second, for when
+        // vsync is off or unavailable. Sleeps until shortly before each
+        // deadline and spins the rest, deadlines don't drift with late
+        // wake-ups. The wait comes before the poll, so the polled input
+        // is as fresh as possible. 0 turns the limit off. Resets the
+        // pacing stats.
+        virtual void SetTargetFrameRate(double hz) = 0;
+
+        virtual FramePacingStats GetFramePacingStats() = 0;
+
+        // Makes SwapBuffers wait until the GPU is at most frames - 1
+        // frames behind, so the frame about to be recorded is at most
+        // the frames-th one queued. Cuts the latency drivers add by
+        // running ahead with vsync off, 1 keeps the CPU and GPU in
+        // lockstep. 0 turns the limit off. Needs sync objects (GL 3.2),
+        // returns false without them or if frames is above 8 and got
+        // clamped. Has to be called on the thread the context is current on.
+        virtual bool SetMaxFramesInFlight(uint32_t frames) = 0;
+
+        // How long the last SwapBuffers waited for the GPU.
+        virtual std::chrono::nanoseconds GetFrameWaitTime() = 0;
+
         virtual bool ShouldClose() = 0;
 
         virtual void Close() = 0;
@@ -234,6 +612,8 @@ namespace awml {
         virtual uint16_t GetWidth() = 0;
         virtual uint16_t GetHeight() = 0;
 
+        // Like IsKeyPressed, the first call requests the events
+        // it's kept up to date with, if nothing else does yet.
         virtual uint16_t GetMouseX() = 0;
         virtual uint16_t GetMouseY() = 0;
         virtual std::pair<uint16_t, uint16_t> GetMouseCoords() = 0;
@@ -242,6 +622,22 @@ namespace awml {
 
         virtual bool IsKeyPressed(awml_key key_code) = 0;
 
+        // Publishes the input state gathered by the event polling
+        // since the previous call as a new InputSnapshot and returns it.
+        // Call once per frame after polling, input events are
+        // requested from the system from the first call on.
+        virtual const InputSnapshot& BeginFrame() = 0;
+
+        // The snapshot published by the last BeginFrame. It's double
+        // buffered and rewritten by the second BeginFrame after it,
+        // so the reference is only safe on the polling thread.
+        virtual const InputSnapshot& GetInputSnapshot() = 0;
+
+        // A copy of the snapshot published by the last BeginFrame,
+        // readable from any thread without locking. A copy that
+        // overlaps a BeginFrame is taken again, so it's never torn.
+        virtual InputSnapshot ReadInputSnapshot() = 0;
+
         virtual void SetCursorMode(CursorMode cursor_mode) = 0;
 
         virtual void SetWindowMode(WindowMode window_mode) = 0;
@@ -252,6 +648,14 @@ namespace awml {
         // Display for Linux
         virtual void* GetNativeHandle() = 0;
 
+        // The requested framebuffer config until the OpenGL context
+        // is set up by Launch, the one that was chosen after that.
+        virtual const FramebufferConfig& GetFramebufferConfig() = 0;
+
+        // The requested context attributes until Launch creates the
+        // OpenGL context, the ones read back from it after that.
+        virtual const ContextConfig& GetContextConfig() = 0;
+
         virtual ~Window() {}
     };
 }
@@ -5,6 +5,8 @@
 #ifdef _WIN32
     #include <GL/wglext.h>
     AWML_GL_API PFNWGLCREATECONTEXTATTRIBSARBPROC wglCreateContextAttribsARB;
+    AWML_GL_API PFNWGLSWAPINTERVALEXTPROC         wglSwapIntervalEXT;
+    AWML_GL_API PFNWGLGETEXTENSIONSSTRINGEXTPROC  wglGetExtensionsStringEXT;
 #elif defined(__linux__)
     #include <GL/gl.h>
     #include <GL/glext.h>
@@ -0,0 +1,205 @@
+#pragma once
+
+#include "awml.h"
+#include "coroutine.h"
+
+namespace awml {
+
+    // A window with a statically selected backend.
+    // Exposes the same API as Window but owns the backend by value,
+    // so every call is resolved at compile time and the hot per-frame
+    // queries (GetWidth, GetMouseX, ShouldClose...) inline to plain loads,
+    // the backends define them in their headers for that.
+    // The backend still implements Window, AsWindow() can be used
+    // wherever the type-erased interface is needed.
+    template<typename Backend>
+    class BasicWindow
+    {
+    private:
+        Backend m_Backend;
+    public:
+        BasicWindow(
+            const std::wstring& title,
+            uint16_t width,
+            uint16_t height,
+            Context context = Context::NONE,
+            WindowMode window_mode = WindowMode::WINDOWED,
+            CursorMode cursor_mode = CursorMode::VISIBLE | CursorMode::FREE,
+            bool resizable = false,
+            const FramebufferConfig& framebuffer = FramebufferConfig(),
+            const ContextConfig& context_config = ContextConfig()
+        ) : m_Backend(
+                title,
+                width,
+                height,
+                context,
+                window_mode,
+                cursor_mode,
+                resizable,
+                framebuffer,
+                context_config
+            )
+        {
+        }
+
+        BasicWindow(const BasicWindow& other) = delete;
+        BasicWindow& operator=(const BasicWindow& other) = delete;
+
+        bool Launch() { return m_Backend.Launch(); }
+
+        bool EnableInputThread(const InputThreadConfig& config = InputThreadConfig())
+        {
+            return m_Backend.EnableInputThread(config);
+        }
+
+        void OnError(error_callback cb)                    { m_Backend.OnError(cb); }
+        void OnKeyPressed(key_pressed_callback cb)         { m_Backend.OnKeyPressed(cb); }
+        void OnKeyReleased(key_released_callback cb)       { m_Backend.OnKeyReleased(cb); }
+        void OnWindowResized(window_resized_callback cb)   { m_Backend.OnWindowResized(cb); }
+        void OnWindowClosed(window_closed_callback cb)     { m_Backend.OnWindowClosed(cb); }
+        void OnMouseMoved(mouse_moved_callback cb)         { m_Backend.OnMouseMoved(cb); }
+        void OnMousePressed(mouse_pressed_callback cb)     { m_Backend.OnMousePressed(cb); }
+        void OnMouseReleased(mouse_released_callback cb)   { m_Backend.OnMouseReleased(cb); }
+        void OnMouseScrolled(mouse_scrolled_callback cb)   { m_Backend.OnMouseScrolled(cb); }
+        void OnCharTyped(char_typed_callback cb)           { m_Backend.OnCharTyped(cb); }
+        void OnUserEvent(user_event_callback cb)           { m_Backend.OnUserEvent(cb); }
+
+        void SetCallbackExecutor(EventType type, callback_executor executor)
+        {
+            m_Backend.SetCallbackExecutor(type, executor);
+        }
+
+        bool PostEvent(const UserEvent& event) { return m_Backend.PostEvent(event); }
+
+        void Wakeup() { m_Backend.Wakeup(); }
+
+        void SetEventCoalescing(Coalesce mode) { m_Backend.SetEventCoalescing(mode); }
+
+        bool StartRecording(const std::string& path) { return m_Backend.StartRecording(path); }
+
+        void StopRecording() { m_Backend.StopRecording(); }
+
+        void SetTitle(const std::wstring& title) { m_Backend.SetTitle(title); }
+
+        void MakeCurrent()    { m_Backend.MakeCurrent(); }
+        void ReleaseCurrent() { m_Backend.ReleaseCurrent(); }
+
+        bool StartRenderThread(render_callback render)
+        {
+            return m_Backend.StartRenderThread(render);
+        }
+
+        void StopRenderThread() { m_Backend.StopRenderThread(); }
+
+        FrameAwaitable NextFrame()         { return m_Backend.NextFrame(); }
+        EventAwaitable NextEvent()         { return m_Backend.NextEvent(); }
+        KeyAwaitable KeyDown(awml_key key) { return m_Backend.KeyDown(key); }
+
+        void PollEvents() { m_Backend.PollEvents(); }
+
+        size_t PollEvents(PollBudget budget) { return m_Backend.PollEvents(budget); }
+
+        size_t DrainEvents(Event* out, size_t max)
+        {
+            return m_Backend.DrainEvents(out, max);
+        }
+
+        void SelectEvents(event_mask mask) { m_Backend.SelectEvents(mask); }
+
+        template<typename Handler>
+        void PollEvents(Handler& handler)
+        {
+            m_Backend.SelectEvents(HandlerEventMask<Handler>());
+
+            Event batch[AWML_EVENT_BATCH_SIZE];
+
+            size_t count;
+            while ((count = m_Backend.DrainEvents(batch, AWML_EVENT_BATCH_SIZE)))
+            {
+                for (size_t i = 0; i < count; ++i)
+                    DispatchEvent(handler, batch[i]);
+            }
+        }
+
+        int GetEventFd() { return m_Backend.GetEventFd(); }
+
+        size_t DispatchPending() { return m_Backend.DispatchPending(); }
+
+        void Flush() { m_Backend.Flush(); }
+
+        void WaitEvents() { m_Backend.WaitEvents(); }
+
+        void WaitEventsTimeout(std::chrono::nanoseconds timeout)
+        {
+            m_Backend.WaitEventsTimeout(timeout);
+        }
+
+        void SwapBuffers() { m_Backend.SwapBuffers(); }
+        void Update()      { m_Backend.Update(); }
+
+        bool SetSwapInterval(int interval) { return m_Backend.SetSwapInterval(interval); }
+
+        SwapControl GetSwapControl() { return m_Backend.GetSwapControl(); }
+
+        void SetTargetFrameRate(double hz) { m_Backend.SetTargetFrameRate(hz); }
+
+        FramePacingStats GetFramePacingStats() { return m_Backend.GetFramePacingStats(); }
+
+        bool SetMaxFramesInFlight(uint32_t frames) { return m_Backend.SetMaxFramesInFlight(frames); }
+
+        std::chrono::nanoseconds GetFrameWaitTime() { return m_Backend.GetFrameWaitTime(); }
+
+        bool ShouldClose() { return m_Backend.ShouldClose(); }
+
+        void Close() { m_Backend.Close(); }
+
+        uint16_t GetWidth()  { return m_Backend.GetWidth(); }
+        uint16_t GetHeight() { return m_Backend.GetHeight(); }
+
+        uint16_t GetMouseX() { return m_Backend.GetMouseX(); }
+        uint16_t GetMouseY() { return m_Backend.GetMouseY(); }
+        std::pair<uint16_t, uint16_t> GetMouseCoords() { return m_Backend.GetMouseCoords(); }
+
+        bool Minimized() { return m_Backend.Minimized(); }
+
+        bool IsKeyPressed(awml_key key_code) { return m_Backend.IsKeyPressed(key_code); }
+
+        const InputSnapshot& BeginFrame()       { return m_Backend.BeginFrame(); }
+        const InputSnapshot& GetInputSnapshot() { return m_Backend.GetInputSnapshot(); }
+        InputSnapshot ReadInputSnapshot()       { return m_Backend.ReadInputSnapshot(); }
+
+        void SetCursorMode(CursorMode cursor_mode) { m_Backend.SetCursorMode(cursor_mode); }
+
+        void SetWindowMode(WindowMode window_mode) { m_Backend.SetWindowMode(window_mode); }
+
+        void Resize(uint16_t width, uint16_t height) { m_Backend.Resize(width, height); }
+
+        void* GetNativeHandle() { return m_Backend.GetNativeHandle(); }
+
+        const FramebufferConfig& GetFramebufferConfig() { return m_Backend.GetFramebufferConfig(); }
+
+        const ContextConfig& GetContextConfig() { return m_Backend.GetContextConfig(); }
+
+        Backend& GetBackend() { return m_Backend; }
+
+        // The type-erased view of this window.
+        Window& AsWindow() { return m_Backend; }
+    };
+}
+
+// The platform backend headers pull in the native
+// windowing headers (windows.h, Xlib.h) so they are
+// only included on request, configure with the
+// AWML_STATIC_BACKEND CMake option to get them.
+#ifdef AWML_STATIC_BACKEND
+    #ifdef _WIN32
+        #include <WindowsWindow.h>
+        namespace awml { typedef BasicWindow<WindowsWindow> NativeWindow; }
+    #elif defined(__linux__)
+        #include <XWindow.h>
+        namespace awml { typedef BasicWindow<XWindow> NativeWindow; }
+    #endif
+
+    #include <NullWindow.h>
+    namespace awml { typedef BasicWindow<NullWindow> HeadlessWindow; }
+#endif
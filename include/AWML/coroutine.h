@@ -0,0 +1,221 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <new>
+#include <type_traits>
+
+#include "awml.h"
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+  #if __has_include(<coroutine>)
+    #include <coroutine>
+    #define AWML_COROUTINES 1
+  #endif
+#endif
+
+namespace awml {
+
+    enum class AwaitKind : uint8_t
+    {
+        FRAME    = 0,
+        EVENT    = 1,
+        KEY_DOWN = 2
+    };
+
+    // A coroutine suspended on a window. The node is part of the
+    // awaitable, which lives in the coroutine frame while it's
+    // suspended, so waiting on a window never allocates.
+    struct AwaitNode
+    {
+        AwaitNode* next;
+
+        AwaitKind kind;
+        awml_key  key;   // KEY_DOWN only
+        Event     event; // The event that resumed an EVENT or KEY_DOWN wait
+
+        // The type-erased coroutine_handle, so the
+        // library itself doesn't need C++20 to resume it.
+        void* coroutine;
+        void (*resume)(void*);
+        void (*destroy)(void*);
+    };
+
+    class Awaitable
+    {
+    protected:
+        Window*   m_Window;
+        AwaitNode m_Node;
+    public:
+        Awaitable(Window& window, AwaitKind kind, awml_key key)
+            : m_Window(&window),
+            m_Node()
+        {
+            m_Node.kind = kind;
+            m_Node.key = key;
+        }
+
+        bool await_ready() const { return false; }
+
+        template<typename Handle>
+        void await_suspend(Handle handle)
+        {
+            m_Node.coroutine = handle.address();
+            m_Node.resume = [](void* address) { Handle::from_address(address).resume(); };
+            m_Node.destroy = [](void* address) { Handle::from_address(address).destroy(); };
+
+            m_Window->Suspend(m_Node);
+        }
+    };
+
+    // Resumes in the first poll after the next SwapBuffers.
+    class FrameAwaitable : public Awaitable
+    {
+    public:
+        explicit FrameAwaitable(Window& window)
+            : Awaitable(window, AwaitKind::FRAME, awml_key::UNKNOWN)
+        {
+        }
+
+        void await_resume() const {}
+    };
+
+    // Resumes with the next event the window consumes.
+    class EventAwaitable : public Awaitable
+    {
+    public:
+        explicit EventAwaitable(Window& window)
+            : Awaitable(window, AwaitKind::EVENT, awml_key::UNKNOWN)
+        {
+        }
+
+        Event await_resume() const { return m_Node.event; }
+    };
+
+    // Resumes with the next press of a key or mouse button,
+    // repeats of a key that is held down don't count.
+    class KeyAwaitable : public Awaitable
+    {
+    public:
+        KeyAwaitable(Window& window, awml_key key)
+            : Awaitable(window, AwaitKind::KEY_DOWN, key)
+        {
+        }
+
+        Event await_resume() const { return m_Node.event; }
+    };
+
+    inline FrameAwaitable Window::NextFrame()
+    {
+        return FrameAwaitable(*this);
+    }
+
+    inline EventAwaitable Window::NextEvent()
+    {
+        return EventAwaitable(*this);
+    }
+
+    inline KeyAwaitable Window::KeyDown(awml_key key)
+    {
+        return KeyAwaitable(*this, key);
+    }
+
+    namespace detail {
+
+        // Every frame starts with the window whose arena it came
+        // from, null for frames from the global heap. Padded so
+        // the frame keeps the alignment of the allocation.
+        constexpr size_t s_FrameHeader = alignof(std::max_align_t);
+
+        inline void* AllocateFrame(Window* window, size_t size)
+        {
+            size += s_FrameHeader;
+
+            void* block = window ? window->AllocateCoroutine(size) : ::operator new(size);
+            *static_cast<Window**>(block) = window;
+
+            return static_cast<char*>(block) + s_FrameHeader;
+        }
+
+        inline void FreeFrame(void* frame, size_t size)
+        {
+            void* block = static_cast<char*>(frame) - s_FrameHeader;
+            Window* window = *static_cast<Window**>(block);
+
+            if (window)
+                window->FreeCoroutine(block, size + s_FrameHeader);
+            else
+                ::operator delete(block);
+        }
+
+        template<typename T>
+        using IsWindow = std::is_base_of<Window, typename std::decay<T>::type>;
+    }
+
+#ifdef AWML_COROUTINES
+    // The return type of coroutines driven by a window. Starts running
+    // right away and frees itself when it finishes, nothing has to keep
+    // it alive. The frame of a coroutine taking the window as its first
+    // parameter (or first after the object for member functions and
+    // lambdas) comes from the window's arena instead of the heap, pass
+    // AsWindow() for a BasicWindow. Coroutines still suspended on a
+    // window are destroyed with it. An exception escaping the
+    // coroutine terminates the program, there is no caller to take it.
+    //
+    //     awml::Task DoubleClick(awml::Window& window)
+    //     {
+    //         for (;;)
+    //         {
+    //             auto first = co_await window.KeyDown(awml_key::MOUSE_LEFT);
+    //             auto second = co_await window.KeyDown(awml_key::MOUSE_LEFT);
+    //             ...
+    //         }
+    //     }
+    class Task
+    {
+    public:
+        struct promise_type
+        {
+            Task get_return_object() { return Task(); }
+
+            std::suspend_never initial_suspend() noexcept { return {}; }
+            std::suspend_never final_suspend() noexcept { return {}; }
+
+            void return_void() {}
+
+            void unhandled_exception() { std::terminate(); }
+
+            template<
+                typename W, typename... Args,
+                typename std::enable_if<detail::IsWindow<W>::value, int>::type = 0
+            >
+            static void* operator new(size_t size, W& window, Args&&...)
+            {
+                return detail::AllocateFrame(&window, size);
+            }
+
+            template<
+                typename T, typename W, typename... Args,
+                typename std::enable_if<
+                    !detail::IsWindow<T>::value && detail::IsWindow<W>::value, int
+                >::type = 0
+            >
+            static void* operator new(size_t size, T&, W& window, Args&&...)
+            {
+                return detail::AllocateFrame(&window, size);
+            }
+
+            static void* operator new(size_t size)
+            {
+                return detail::AllocateFrame(nullptr, size);
+            }
+
+            static void operator delete(void* frame, size_t size)
+            {
+                detail::FreeFrame(frame, size);
+            }
+        };
+    };
+#endif
+}
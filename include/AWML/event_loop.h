@@ -0,0 +1,112 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+#include "awml.h"
+
+namespace awml {
+
+    enum class FdEvent : uint8_t
+    {
+        NONE     = 0,
+
+        READABLE = 1,
+        WRITABLE = 2,
+        HANGUP   = 4  // Reported even if not requested
+    };
+
+    inline FdEvent operator|(FdEvent l, FdEvent r)
+    {
+        return static_cast<FdEvent>(
+            static_cast<uint8_t>(l) |
+            static_cast<uint8_t>(r)
+        );
+    }
+
+    inline uint8_t operator&(FdEvent l, FdEvent r)
+    {
+        return static_cast<uint8_t>(l) &
+               static_cast<uint8_t>(r);
+    }
+
+    // Identifies a timer of an EventLoop, 0 is never a valid id.
+    typedef uint32_t timer_id;
+
+    // A callback that gets called when a timer expires.
+    typedef std::function<void()>
+        timer_callback;
+
+    // A callback that gets called when a watched fd is ready.
+    // Parameters:
+    // int -> The fd.
+    // FdEvent -> What the fd is ready for.
+    typedef std::function<void(int, FdEvent)>
+        fd_callback;
+
+    // A reactor that sleeps until one of its windows has events,
+    // a timer expires or a watched fd becomes ready, and then
+    // dispatches whatever is ready. Replaces the busy
+    // while (!ShouldClose()) Update() loop.
+    // All methods other than Stop have to be called from
+    // the thread running the loop (or before it runs).
+    class EventLoop
+    {
+    public:
+        typedef std::unique_ptr<EventLoop>
+            UniqueEventLoop;
+    public:
+        static UniqueEventLoop Create();
+
+        EventLoop(const EventLoop& other) = delete;
+        EventLoop& operator=(const EventLoop& other) = delete;
+    protected:
+        EventLoop() {}
+    public:
+        virtual void OnError(
+            error_callback cb
+        ) = 0;
+
+        // Dispatches the events of a launched window to its callbacks
+        // as they arrive (see Window::DispatchPending). The window has
+        // to outlive the loop or be removed first.
+        virtual bool AddWindow(Window& window) = 0;
+
+        virtual void RemoveWindow(Window& window) = 0;
+
+        // Calls cb once after delay, and then every interval
+        // if the interval is not zero.
+        virtual timer_id AddTimer(
+            std::chrono::nanoseconds delay,
+            timer_callback cb,
+            std::chrono::nanoseconds interval = std::chrono::nanoseconds::zero()
+        ) = 0;
+
+        virtual void CancelTimer(timer_id id) = 0;
+
+        // Calls cb whenever fd is ready for one of the events.
+        // The fd stays owned by the caller, watching it again
+        // replaces the previous watch.
+        virtual bool WatchFd(int fd, FdEvent events, fd_callback cb) = 0;
+
+        virtual void UnwatchFd(int fd) = 0;
+
+        // Dispatches until Stop is called or every
+        // added window has been asked to close.
+        virtual void Run() = 0;
+
+        // Waits up to timeout for something to become ready and
+        // dispatches it, a negative timeout waits indefinitely.
+        // Returns false once the loop should stop.
+        virtual bool RunOnce(
+            std::chrono::nanoseconds timeout = std::chrono::nanoseconds(-1)
+        ) = 0;
+
+        // Makes Run return, can be called from any thread.
+        virtual void Stop() = 0;
+
+        virtual ~EventLoop() {}
+    };
+}
@@ -0,0 +1,379 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include "key_codes.h"
+
+// Amount of events handed to the callbacks/handlers per pass.
+#define AWML_EVENT_BATCH_SIZE 64
+
+namespace awml {
+
+    enum class EventType : uint8_t
+    {
+        NONE           = 0,
+
+        KEY_PRESSED    = 1,
+        KEY_RELEASED   = 2,
+        WINDOW_RESIZED = 3,
+        WINDOW_CLOSED  = 4,
+        MOUSE_MOVED    = 5,
+        MOUSE_PRESSED  = 6,
+        MOUSE_RELEASED = 7,
+        MOUSE_SCROLLED = 8,
+        CHAR_TYPED     = 9,
+        USER           = 10
+    };
+
+    struct KeyEvent
+    {
+        awml_key key;
+        uint16_t repeat_count;
+        bool     repeated;
+    };
+
+    struct SizeEvent
+    {
+        uint16_t width;
+        uint16_t height;
+    };
+
+    struct MouseMoveEvent
+    {
+        uint16_t x;
+        uint16_t y;
+    };
+
+    struct ButtonEvent
+    {
+        awml_key button;
+    };
+
+    struct ScrollEvent
+    {
+        int16_t delta;
+        bool    vertical;
+    };
+
+    struct CharEvent
+    {
+        wchar_t character;
+    };
+
+    // An application defined event, see Window::PostEvent.
+    struct UserEvent
+    {
+        uint32_t code;
+        void*    data;
+    };
+
+    // A set of event types, one bit per EventType.
+    typedef uint32_t event_mask;
+
+    constexpr event_mask EventBit(EventType type)
+    {
+        return 1u << static_cast<uint8_t>(type);
+    }
+
+    constexpr event_mask ALL_EVENTS = ~event_mask(0);
+
+    // Classes of events that can be merged before being queued,
+    // see Window::SetEventCoalescing.
+    enum class Coalesce : uint8_t
+    {
+        NONE         = 0,
+
+        MOUSE_MOTION = 1, // Consecutive moves become one with the latest position
+        RESIZE       = 2, // At most one resize (the latest size) per poll
+        KEY_REPEAT   = 4, // Consecutive repeats of the same key become one
+
+        ALL          = MOUSE_MOTION | RESIZE | KEY_REPEAT
+    };
+
+    inline Coalesce operator|(Coalesce l, Coalesce r)
+    {
+        return static_cast<Coalesce>(
+            static_cast<uint8_t>(l) |
+            static_cast<uint8_t>(r)
+        );
+    }
+
+    inline uint8_t operator&(Coalesce l, Coalesce r)
+    {
+        return static_cast<uint8_t>(l) &
+               static_cast<uint8_t>(r);
+    }
+
+    // A compact record of a single decoded window event.
+    // Only the member matching the type is valid.
+    struct Event
+    {
+        EventType type;
+
+        // Number of raw system events this event represents,
+        // more than 1 if several of them were coalesced.
+        uint16_t count;
+
+        // Monotonic time the event was read from
+        // the system, in nanoseconds.
+        uint64_t timestamp;
+
+        union
+        {
+            KeyEvent       key;    // KEY_PRESSED, KEY_RELEASED
+            SizeEvent      size;   // WINDOW_RESIZED
+            MouseMoveEvent mouse;  // MOUSE_MOVED
+            ButtonEvent    button; // MOUSE_PRESSED, MOUSE_RELEASED
+            ScrollEvent    scroll; // MOUSE_SCROLLED
+            CharEvent      text;   // CHAR_TYPED
+            UserEvent      user;   // USER
+        };
+    };
+
+    static_assert(
+        std::is_trivially_copyable<Event>::value,
+        "awml::Event has to stay trivially copyable"
+    );
+
+    namespace detail {
+
+        // Each event is forwarded to the matching handler method if
+        // the handler has one, otherwise the call compiles out.
+        // The int/long parameter makes the first overload preferred.
+
+        template<typename Handler>
+        auto KeyPressed(Handler& h, const KeyEvent& e, int)
+            -> decltype(h.OnKeyPressed(e.key, e.repeated, e.repeat_count), void())
+        {
+            h.OnKeyPressed(e.key, e.repeated, e.repeat_count);
+        }
+
+        template<typename Handler>
+        void KeyPressed(Handler&, const KeyEvent&, long) {}
+
+        template<typename Handler>
+        auto KeyReleased(Handler& h, const KeyEvent& e, int)
+            -> decltype(h.OnKeyReleased(e.key), void())
+        {
+            h.OnKeyReleased(e.key);
+        }
+
+        template<typename Handler>
+        void KeyReleased(Handler&, const KeyEvent&, long) {}
+
+        template<typename Handler>
+        auto WindowResized(Handler& h, const SizeEvent& e, int)
+            -> decltype(h.OnWindowResized(e.width, e.height), void())
+        {
+            h.OnWindowResized(e.width, e.height);
+        }
+
+        template<typename Handler>
+        void WindowResized(Handler&, const SizeEvent&, long) {}
+
+        template<typename Handler>
+        auto WindowClosed(Handler& h, int)
+            -> decltype(h.OnWindowClosed(), void())
+        {
+            h.OnWindowClosed();
+        }
+
+        template<typename Handler>
+        void WindowClosed(Handler&, long) {}
+
+        template<typename Handler>
+        auto MouseMoved(Handler& h, const MouseMoveEvent& e, int)
+            -> decltype(h.OnMouseMoved(e.x, e.y), void())
+        {
+            h.OnMouseMoved(e.x, e.y);
+        }
+
+        template<typename Handler>
+        void MouseMoved(Handler&, const MouseMoveEvent&, long) {}
+
+        template<typename Handler>
+        auto MousePressed(Handler& h, const ButtonEvent& e, int)
+            -> decltype(h.OnMousePressed(e.button), void())
+        {
+            h.OnMousePressed(e.button);
+        }
+
+        template<typename Handler>
+        void MousePressed(Handler&, const ButtonEvent&, long) {}
+
+        template<typename Handler>
+        auto MouseReleased(Handler& h, const ButtonEvent& e, int)
+            -> decltype(h.OnMouseReleased(e.button), void())
+        {
+            h.OnMouseReleased(e.button);
+        }
+
+        template<typename Handler>
+        void MouseReleased(Handler&, const ButtonEvent&, long) {}
+
+        template<typename Handler>
+        auto MouseScrolled(Handler& h, const ScrollEvent& e, int)
+            -> decltype(h.OnMouseScrolled(e.delta, e.vertical), void())
+        {
+            h.OnMouseScrolled(e.delta, e.vertical);
+        }
+
+        template<typename Handler>
+        void MouseScrolled(Handler&, const ScrollEvent&, long) {}
+
+        template<typename Handler>
+        auto CharTyped(Handler& h, const CharEvent& e, int)
+            -> decltype(h.OnCharTyped(e.character), void())
+        {
+            h.OnCharTyped(e.character);
+        }
+
+        template<typename Handler>
+        void CharTyped(Handler&, const CharEvent&, long) {}
+
+        template<typename Handler>
+        auto UserEventReceived(Handler& h, const UserEvent& e, int)
+            -> decltype(h.OnUserEvent(e.code, e.data), void())
+        {
+            h.OnUserEvent(e.code, e.data);
+        }
+
+        template<typename Handler>
+        void UserEventReceived(Handler&, const UserEvent&, long) {}
+
+        // The same detection, used to work out at
+        // compile time which events a handler wants.
+
+        template<typename Handler>
+        auto HandlesKeyPressed(int)
+            -> decltype(std::declval<Handler&>().OnKeyPressed(awml_key(), bool(), uint16_t()), std::true_type());
+        template<typename Handler>
+        std::false_type HandlesKeyPressed(long);
+
+        template<typename Handler>
+        auto HandlesKeyReleased(int)
+            -> decltype(std::declval<Handler&>().OnKeyReleased(awml_key()), std::true_type());
+        template<typename Handler>
+        std::false_type HandlesKeyReleased(long);
+
+        template<typename Handler>
+        auto HandlesWindowResized(int)
+            -> decltype(std::declval<Handler&>().OnWindowResized(uint16_t(), uint16_t()), std::true_type());
+        template<typename Handler>
+        std::false_type HandlesWindowResized(long);
+
+        template<typename Handler>
+        auto HandlesWindowClosed(int)
+            -> decltype(std::declval<Handler&>().OnWindowClosed(), std::true_type());
+        template<typename Handler>
+        std::false_type HandlesWindowClosed(long);
+
+        template<typename Handler>
+        auto HandlesMouseMoved(int)
+            -> decltype(std::declval<Handler&>().OnMouseMoved(uint16_t(), uint16_t()), std::true_type());
+        template<typename Handler>
+        std::false_type HandlesMouseMoved(long);
+
+        template<typename Handler>
+        auto HandlesMousePressed(int)
+            -> decltype(std::declval<Handler&>().OnMousePressed(awml_key()), std::true_type());
+        template<typename Handler>
+        std::false_type HandlesMousePressed(long);
+
+        template<typename Handler>
+        auto HandlesMouseReleased(int)
+            -> decltype(std::declval<Handler&>().OnMouseReleased(awml_key()), std::true_type());
+        template<typename Handler>
+        std::false_type HandlesMouseReleased(long);
+
+        template<typename Handler>
+        auto HandlesMouseScrolled(int)
+            -> decltype(std::declval<Handler&>().OnMouseScrolled(int16_t(), bool()), std::true_type());
+        template<typename Handler>
+        std::false_type HandlesMouseScrolled(long);
+
+        template<typename Handler>
+        auto HandlesCharTyped(int)
+            -> decltype(std::declval<Handler&>().OnCharTyped(wchar_t()), std::true_type());
+        template<typename Handler>
+        std::false_type HandlesCharTyped(long);
+
+        template<typename Handler>
+        auto HandlesUserEvent(int)
+            -> decltype(std::declval<Handler&>().OnUserEvent(uint32_t(), static_cast<void*>(nullptr)), std::true_type());
+        template<typename Handler>
+        std::false_type HandlesUserEvent(long);
+    }
+
+    // The set of event types a handler has methods for.
+    template<typename Handler>
+    constexpr event_mask HandlerEventMask()
+    {
+        return
+            (decltype(detail::HandlesKeyPressed<Handler>(0))::value    ? EventBit(EventType::KEY_PRESSED)    : 0) |
+            (decltype(detail::HandlesKeyReleased<Handler>(0))::value   ? EventBit(EventType::KEY_RELEASED)   : 0) |
+            (decltype(detail::HandlesWindowResized<Handler>(0))::value ? EventBit(EventType::WINDOW_RESIZED) : 0) |
+            (decltype(detail::HandlesWindowClosed<Handler>(0))::value  ? EventBit(EventType::WINDOW_CLOSED)  : 0) |
+            (decltype(detail::HandlesMouseMoved<Handler>(0))::value    ? EventBit(EventType::MOUSE_MOVED)    : 0) |
+            (decltype(detail::HandlesMousePressed<Handler>(0))::value  ? EventBit(EventType::MOUSE_PRESSED)  : 0) |
+            (decltype(detail::HandlesMouseReleased<Handler>(0))::value ? EventBit(EventType::MOUSE_RELEASED) : 0) |
+            (decltype(detail::HandlesMouseScrolled<Handler>(0))::value ? EventBit(EventType::MOUSE_SCROLLED) : 0) |
+            (decltype(detail::HandlesCharTyped<Handler>(0))::value     ? EventBit(EventType::CHAR_TYPED)     : 0) |
+            (decltype(detail::HandlesUserEvent<Handler>(0))::value     ? EventBit(EventType::USER)           : 0);
+    }
+
+    // Forwards an event to the matching method of the handler.
+    // Handler is any type with some of the following methods:
+    // OnKeyPressed(awml_key, bool, uint16_t)
+    // OnKeyReleased(awml_key)
+    // OnWindowResized(uint16_t, uint16_t)
+    // OnWindowClosed()
+    // OnMouseMoved(uint16_t, uint16_t)
+    // OnMousePressed(awml_key)
+    // OnMouseReleased(awml_key)
+    // OnMouseScrolled(int16_t, bool)
+    // OnCharTyped(wchar_t)
+    // OnUserEvent(uint32_t, void*)
+    // The parameters match the ones of the respective callbacks.
+    template<typename Handler>
+    inline void DispatchEvent(Handler& handler, const Event& event)
+    {
+        switch (event.type)
+        {
+        case EventType::KEY_PRESSED:
+            detail::KeyPressed(handler, event.key, 0);
+            break;
+        case EventType::KEY_RELEASED:
+            detail::KeyReleased(handler, event.key, 0);
+            break;
+        case EventType::WINDOW_RESIZED:
+            detail::WindowResized(handler, event.size, 0);
+            break;
+        case EventType::WINDOW_CLOSED:
+            detail::WindowClosed(handler, 0);
+            break;
+        case EventType::MOUSE_MOVED:
+            detail::MouseMoved(handler, event.mouse, 0);
+            break;
+        case EventType::MOUSE_PRESSED:
+            detail::MousePressed(handler, event.button, 0);
+            break;
+        case EventType::MOUSE_RELEASED:
+            detail::MouseReleased(handler, event.button, 0);
+            break;
+        case EventType::MOUSE_SCROLLED:
+            detail::MouseScrolled(handler, event.scroll, 0);
+            break;
+        case EventType::CHAR_TYPED:
+            detail::CharTyped(handler, event.text, 0);
+            break;
+        case EventType::USER:
+            detail::UserEventReceived(handler, event.user, 0);
+            break;
+        default:
+            break;
+        }
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include "awml.h"
+
+namespace awml {
+
+    // Drives a headless window (WindowBackend::HEADLESS) in place of a
+    // window system. Injected events go through the same queue,
+    // coalescer, callbacks and window state as on the native backends.
+    // Time comes from a fake clock that only moves when told to, a
+    // wait with a timeout advances it instead of sleeping.
+    class HeadlessControl
+    {
+    public:
+        // Queues an event as if it was read from the window system.
+        // Has to be called from the polling thread, see PostEvent
+        // for other threads. A zero timestamp is replaced with the
+        // current time. Returns false if the queue is full.
+        virtual bool InjectEvent(const Event& event) = 0;
+
+        // Sets or advances the fake clock, which starts at 0.
+        virtual void SetTime(uint64_t nanoseconds) = 0;
+        virtual void AdvanceTime(std::chrono::nanoseconds delta) = 0;
+
+        virtual uint64_t GetTime() = 0;
+
+        // Number of SwapBuffers calls so far.
+        virtual uint64_t GetFrameCount() = 0;
+
+        virtual ~HeadlessControl() {}
+    };
+
+    // The control of a headless window, null for the other backends.
+    HeadlessControl* GetHeadlessControl(Window& window);
+}
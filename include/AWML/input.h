@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "key_codes.h"
+
+// Maximum amount of characters an InputSnapshot keeps per frame.
+#define AWML_TEXT_INPUT_SIZE 32
+
+namespace awml {
+
+    // A set of keys, one bit per awml_key.
+    struct KeySet
+    {
+        static constexpr size_t s_Words = (AWML_KEY_COUNT + 63) / 64;
+
+        uint64_t bits[s_Words];
+
+        bool Test(awml_key key) const
+        {
+            auto index = static_cast<size_t>(key);
+            return (bits[index / 64] >> (index % 64)) & 1;
+        }
+
+        void Set(awml_key key)
+        {
+            auto index = static_cast<size_t>(key);
+            bits[index / 64] |= 1ull << (index % 64);
+        }
+
+        void Reset(awml_key key)
+        {
+            auto index = static_cast<size_t>(key);
+            bits[index / 64] &= ~(1ull << (index % 64));
+        }
+    };
+
+    // The input state of a window for a single frame, published by
+    // Window::BeginFrame. The references BeginFrame and GetInputSnapshot
+    // return are for the polling thread only. Other threads get a
+    // consistent copy from Window::ReadInputSnapshot.
+    struct InputSnapshot
+    {
+        // Incremented by every BeginFrame.
+        uint64_t frame;
+
+        KeySet down;     // Keys and mouse buttons held right now
+        KeySet pressed;  // Went down since the previous frame
+        KeySet released; // Went up since the previous frame
+
+        uint16_t mouse_x;
+        uint16_t mouse_y;
+        int32_t  mouse_dx;
+        int32_t  mouse_dy;
+
+        // Scroll accumulated since the previous frame.
+        int32_t scroll_x;
+        int32_t scroll_y;
+
+        // Characters typed since the previous frame,
+        // the ones past AWML_TEXT_INPUT_SIZE are dropped.
+        wchar_t text[AWML_TEXT_INPUT_SIZE];
+        uint8_t text_length;
+
+        bool IsDown(awml_key key)      const { return down.Test(key); }
+        bool WasPressed(awml_key key)  const { return pressed.Test(key); }
+        bool WasReleased(awml_key key) const { return released.Test(key); }
+    };
+}
@@ -0,0 +1,249 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <AWML/coroutine.h>
+
+namespace awml {
+
+    // Recycles coroutine frames by size class so a coroutine that is
+    // started over and over (one per gesture, per dialog...) stops
+    // hitting the heap after the first few. Only used from the
+    // polling thread, large frames go to the heap.
+    class CoroutineArena
+    {
+    private:
+        static constexpr size_t s_Granularity = 64;
+        static constexpr size_t s_Classes     = 16;
+        static constexpr size_t s_ChunkSize   = 16 * 1024;
+
+        struct FreeBlock
+        {
+            FreeBlock* next;
+        };
+
+        FreeBlock* m_Free[s_Classes];
+
+        std::vector<std::unique_ptr<char[]>> m_Chunks;
+        char* m_Cursor;
+        char* m_End;
+    public:
+        CoroutineArena()
+            : m_Free(),
+            m_Chunks(),
+            m_Cursor(nullptr),
+            m_End(nullptr)
+        {
+        }
+
+        CoroutineArena(const CoroutineArena& other) = delete;
+        CoroutineArena& operator=(const CoroutineArena& other) = delete;
+
+        void* Allocate(size_t size)
+        {
+            size_t index = (size - 1) / s_Granularity;
+
+            if (index >= s_Classes)
+                return ::operator new(size);
+
+            if (FreeBlock* block = m_Free[index])
+            {
+                m_Free[index] = block->next;
+                return block;
+            }
+
+            size_t rounded = (index + 1) * s_Granularity;
+
+            if (static_cast<size_t>(m_End - m_Cursor) < rounded)
+            {
+                // The tail of the old chunk is left unused.
+                m_Chunks.emplace_back(new char[s_ChunkSize]);
+                m_Cursor = m_Chunks.back().get();
+                m_End = m_Cursor + s_ChunkSize;
+            }
+
+            void* block = m_Cursor;
+            m_Cursor += rounded;
+
+            return block;
+        }
+
+        void Free(void* frame, size_t size)
+        {
+            size_t index = (size - 1) / s_Granularity;
+
+            if (index >= s_Classes)
+            {
+                ::operator delete(frame);
+                return;
+            }
+
+            auto block = static_cast<FreeBlock*>(frame);
+            block->next = m_Free[index];
+            m_Free[index] = block;
+        }
+    };
+
+    // The coroutines suspended on a window, in the order they
+    // suspended. Frame waiters are resumed by the first poll after
+    // a SwapBuffers, event waiters by ApplyEvent as the events are
+    // consumed, so the window state already reflects the event.
+    class AwaitQueue
+    {
+    private:
+        struct List
+        {
+            AwaitNode* head;
+            AwaitNode* tail;
+
+            void Push(AwaitNode& node)
+            {
+                node.next = nullptr;
+
+                if (tail)
+                    tail->next = &node;
+                else
+                    head = &node;
+
+                tail = &node;
+            }
+
+            // Leaves the list empty, so coroutines suspending
+            // while the taken ones resume wait for the next round.
+            AwaitNode* Take()
+            {
+                AwaitNode* taken = head;
+                head = tail = nullptr;
+                return taken;
+            }
+        };
+
+        CoroutineArena m_Arena;
+
+        List m_Frame;
+        List m_Events;
+
+        // SwapBuffers may run on the render thread.
+        std::atomic<bool> m_FrameEnded;
+
+        // Event types waited on so far, stays set
+        // so the input mask isn't updated on every wait.
+        event_mask m_Interest;
+    public:
+        AwaitQueue()
+            : m_Arena(),
+            m_Frame { nullptr, nullptr },
+            m_Events { nullptr, nullptr },
+            m_FrameEnded(false),
+            m_Interest(0)
+        {
+        }
+
+        AwaitQueue(const AwaitQueue& other) = delete;
+        AwaitQueue& operator=(const AwaitQueue& other) = delete;
+
+        CoroutineArena& Arena() { return m_Arena; }
+
+        event_mask Mask() const { return m_Interest; }
+
+        // Returns true if the event types waited on grew.
+        bool Push(AwaitNode& node)
+        {
+            if (node.kind == AwaitKind::FRAME)
+            {
+                m_Frame.Push(node);
+                return false;
+            }
+
+            m_Events.Push(node);
+
+            event_mask wanted = node.kind == AwaitKind::EVENT ?
+                ALL_EVENTS :
+                EventBit(EventType::KEY_PRESSED) | EventBit(EventType::MOUSE_PRESSED);
+
+            if ((m_Interest & wanted) == wanted)
+                return false;
+
+            m_Interest |= wanted;
+
+            return true;
+        }
+
+        void EndFrame()
+        {
+            m_FrameEnded.store(true, std::memory_order_relaxed);
+        }
+
+        void ResumeFrame()
+        {
+            if (!m_FrameEnded.exchange(false, std::memory_order_relaxed))
+                return;
+
+            AwaitNode* node = m_Frame.Take();
+
+            while (node)
+            {
+                // The node goes away with the awaitable once resumed.
+                AwaitNode* next = node->next;
+                node->resume(node->coroutine);
+                node = next;
+            }
+        }
+
+        void ResumeEvent(const Event& event)
+        {
+            if (!m_Events.head)
+                return;
+
+            AwaitNode* node = m_Events.Take();
+
+            while (node)
+            {
+                AwaitNode* next = node->next;
+
+                if (Matches(*node, event))
+                {
+                    node->event = event;
+                    node->resume(node->coroutine);
+                }
+                else
+                {
+                    m_Events.Push(*node);
+                }
+
+                node = next;
+            }
+        }
+
+        // Destroys the coroutines that are still suspended, has to be
+        // called while the window can still free their frames.
+        void DestroySuspended()
+        {
+            DestroyList(m_Frame.Take());
+            DestroyList(m_Events.Take());
+        }
+    private:
+        static bool Matches(const AwaitNode& node, const Event& event)
+        {
+            if (node.kind == AwaitKind::EVENT)
+                return true;
+
+            if (event.type == EventType::KEY_PRESSED)
+                return event.key.key == node.key && !event.key.repeated;
+
+            return event.type == EventType::MOUSE_PRESSED && event.button.button == node.key;
+        }
+
+        static void DestroyList(AwaitNode* node)
+        {
+            while (node)
+            {
+                AwaitNode* next = node->next;
+                node->destroy(node->coroutine);
+                node = next;
+            }
+        }
+    };
+}
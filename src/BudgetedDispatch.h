@@ -0,0 +1,96 @@
+#pragma once
+
+#include <chrono>
+
+#include <AWML/awml.h>
+
+#include "EventCoalescer.h"
+
+namespace awml {
+
+    // Dispatches queued events within the limits of a PollBudget.
+    // Input-critical events are taken from anywhere in the queue
+    // first, then the bulk motion events in order. Events taken
+    // out of order are marked NONE and skipped when popped later.
+    class BudgetedDispatch
+    {
+    private:
+        typedef std::chrono::steady_clock clock;
+
+        PollBudget        m_Budget;
+        clock::time_point m_Deadline;
+        size_t            m_Dispatched;
+    public:
+        explicit BudgetedDispatch(const PollBudget& budget)
+            : m_Budget(budget),
+            m_Deadline(clock::now() + budget.max_time),
+            m_Dispatched(0)
+        {
+        }
+
+        bool Exhausted() const
+        {
+            if (m_Budget.max_events && m_Dispatched >= m_Budget.max_events)
+                return true;
+
+            return m_Budget.max_time.count() > 0 && clock::now() >= m_Deadline;
+        }
+
+        // apply is called with every event before it is
+        // handed to the handler, to update the window state.
+        template<typename Handler, typename Apply>
+        void Run(EventQueue& queue, Handler& handler, Apply apply)
+        {
+            size_t queued = queue.Size();
+
+            for (size_t i = 0; i < queued && !Exhausted(); ++i)
+            {
+                Event& event = queue.At(i);
+
+                if (event.type == EventType::NONE ||
+                    event.type == EventType::MOUSE_MOVED)
+                    continue;
+
+                Dispatch(event, handler, apply);
+                event.type = EventType::NONE;
+            }
+
+            size_t consumed = 0;
+
+            for (; consumed < queued; ++consumed)
+            {
+                Event& event = queue.At(consumed);
+
+                if (event.type == EventType::NONE)
+                    continue;
+
+                if (Exhausted())
+                    break;
+
+                Dispatch(event, handler, apply);
+            }
+
+            queue.Discard(consumed);
+        }
+
+        // Events still waiting in the queue.
+        static size_t Backlog(EventQueue& queue)
+        {
+            size_t queued = queue.Size();
+            size_t backlog = 0;
+
+            for (size_t i = 0; i < queued; ++i)
+                backlog += queue.At(i).type != EventType::NONE;
+
+            return backlog;
+        }
+    private:
+        template<typename Handler, typename Apply>
+        void Dispatch(const Event& event, Handler& handler, Apply& apply)
+        {
+            apply(event);
+            DispatchEvent(handler, event);
+            ++m_Dispatched;
+        }
+    };
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <functional>
+
+#include <AWML/awml.h>
+
+namespace awml {
+
+    // The event handler backing the OnKeyPressed/OnMouseMoved/...
+    // callback API, dispatched through the same DispatchEvent
+    // path as user supplied handlers.
+    struct CallbackHandler
+    {
+        key_pressed_callback    key_pressed;
+        key_released_callback   key_released;
+        window_resized_callback window_resized;
+        window_closed_callback  window_closed;
+        mouse_moved_callback    mouse_moved;
+        mouse_pressed_callback  mouse_pressed;
+        mouse_released_callback mouse_released;
+        mouse_scrolled_callback mouse_scrolled;
+        char_typed_callback     char_typed;
+        user_event_callback     user_event;
+
+        // Indexed by EventType, empty ones call inline.
+        callback_executor executors[static_cast<size_t>(EventType::USER) + 1];
+
+        // The event types that currently have a callback.
+        event_mask Mask() const
+        {
+            return
+                (key_pressed    ? EventBit(EventType::KEY_PRESSED)    : 0) |
+                (key_released   ? EventBit(EventType::KEY_RELEASED)   : 0) |
+                (window_resized ? EventBit(EventType::WINDOW_RESIZED) : 0) |
+                (window_closed  ? EventBit(EventType::WINDOW_CLOSED)  : 0) |
+                (mouse_moved    ? EventBit(EventType::MOUSE_MOVED)    : 0) |
+                (mouse_pressed  ? EventBit(EventType::MOUSE_PRESSED)  : 0) |
+                (mouse_released ? EventBit(EventType::MOUSE_RELEASED) : 0) |
+                (mouse_scrolled ? EventBit(EventType::MOUSE_SCROLLED) : 0) |
+                (char_typed     ? EventBit(EventType::CHAR_TYPED)     : 0) |
+                (user_event     ? EventBit(EventType::USER)           : 0);
+        }
+
+        // Returns false if there are no callbacks for the type.
+        bool SetExecutor(EventType type, callback_executor executor)
+        {
+            if (type == EventType::NONE || type > EventType::USER)
+                return false;
+
+            executors[static_cast<size_t>(type)] = executor;
+
+            return true;
+        }
+
+        void OnKeyPressed(awml_key key, bool repeated, uint16_t repeat_count)
+        {
+            Invoke(EventType::KEY_PRESSED, key_pressed, key, repeated, repeat_count);
+        }
+
+        void OnKeyReleased(awml_key key)
+        {
+            Invoke(EventType::KEY_RELEASED, key_released, key);
+        }
+
+        void OnWindowResized(uint16_t width, uint16_t height)
+        {
+            Invoke(EventType::WINDOW_RESIZED, window_resized, width, height);
+        }
+
+        void OnWindowClosed()
+        {
+            Invoke(EventType::WINDOW_CLOSED, window_closed);
+        }
+
+        void OnMouseMoved(uint16_t x, uint16_t y)
+        {
+            Invoke(EventType::MOUSE_MOVED, mouse_moved, x, y);
+        }
+
+        void OnMousePressed(awml_key button)
+        {
+            Invoke(EventType::MOUSE_PRESSED, mouse_pressed, button);
+        }
+
+        void OnMouseReleased(awml_key button)
+        {
+            Invoke(EventType::MOUSE_RELEASED, mouse_released, button);
+        }
+
+        void OnMouseScrolled(int16_t delta, bool vertical)
+        {
+            Invoke(EventType::MOUSE_SCROLLED, mouse_scrolled, delta, vertical);
+        }
+
+        void OnCharTyped(wchar_t character)
+        {
+            Invoke(EventType::CHAR_TYPED, char_typed, character);
+        }
+
+        void OnUserEvent(uint32_t code, void* data)
+        {
+            Invoke(EventType::USER, user_event, code, data);
+        }
+    private:
+        // Calls cb right away, or binds it to the
+        // event's parameters for the type's executor.
+        template<typename Callback, typename... Args>
+        void Invoke(EventType type, const Callback& cb, Args... args)
+        {
+            if (!cb)
+                return;
+
+            const auto& executor = executors[static_cast<size_t>(type)];
+
+            if (executor)
+                executor(std::bind(cb, args...));
+            else
+                cb(args...);
+        }
+    };
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <atomic>
+
+#include <AWML/events.h>
+
+#include "RingBuffer.h"
+#include "utilities.h"
+
+namespace awml {
+
+    typedef RingBuffer<Event, AWML_EVENT_QUEUE_SIZE>
+        EventQueue;
+
+    // Sits between the decoder and the event queue and merges
+    // floods of motion/resize/key repeat events according to
+    // the configured mode. Only ever used by the producer thread,
+    // the mode may be changed from anywhere.
+    class EventCoalescer
+    {
+    private:
+        EventQueue& m_Queue;
+
+        std::atomic<uint8_t> m_Mode;
+
+        Event m_Pending;
+        bool  m_HasPending;
+
+        Event m_Resize;
+        bool  m_HasResize;
+    public:
+        // Maximum amount of events Flush can push.
+        static constexpr size_t s_MaxHeld = 2;
+
+        explicit EventCoalescer(EventQueue& queue)
+            : m_Queue(queue),
+            m_Mode(static_cast<uint8_t>(Coalesce::NONE)),
+            m_Pending(),
+            m_HasPending(false),
+            m_Resize(),
+            m_HasResize(false)
+        {
+        }
+
+        void SetMode(Coalesce mode)
+        {
+            m_Mode.store(static_cast<uint8_t>(mode), std::memory_order_relaxed);
+        }
+
+        // Queues the event, or merges it into a held one.
+        // Pushes at most one event into the queue.
+        void Stage(const Event& event)
+        {
+            auto mode = static_cast<Coalesce>(m_Mode.load(std::memory_order_relaxed));
+
+            if (mode == Coalesce::NONE && !m_HasPending && !m_HasResize)
+            {
+                m_Queue.Push(event);
+                return;
+            }
+
+            if ((mode & Coalesce::RESIZE) && event.type == EventType::WINDOW_RESIZED)
+            {
+                uint16_t count = m_HasResize ? m_Resize.count : 0;
+
+                m_Resize = event;
+                m_Resize.count = Saturate(count + event.count);
+                m_HasResize = true;
+
+                return;
+            }
+
+            if (m_HasPending && CanMerge(mode, m_Pending, event))
+            {
+                uint16_t count = m_Pending.count;
+
+                m_Pending = event;
+                m_Pending.count = Saturate(count + event.count);
+
+                return;
+            }
+
+            if (m_HasPending)
+                m_Queue.Push(m_Pending);
+
+            m_Pending = event;
+            m_HasPending = true;
+        }
+
+        // Pushes everything that's being held back,
+        // called at the end of every pump.
+        void Flush()
+        {
+            if (m_HasPending)
+                m_Queue.Push(m_Pending);
+
+            if (m_HasResize)
+                m_Queue.Push(m_Resize);
+
+            m_HasPending = false;
+            m_HasResize = false;
+        }
+    private:
+        static bool CanMerge(Coalesce mode, const Event& held, const Event& next)
+        {
+            if (held.type != next.type)
+                return false;
+
+            switch (next.type)
+            {
+            case EventType::MOUSE_MOVED:
+                return mode & Coalesce::MOUSE_MOTION;
+            case EventType::KEY_PRESSED:
+                return (mode & Coalesce::KEY_REPEAT) &&
+                       held.key.repeated &&
+                       next.key.repeated &&
+                       held.key.key == next.key.key;
+            default:
+                return false;
+            }
+        }
+
+        static uint16_t Saturate(uint32_t count)
+        {
+            return count > UINT16_MAX ? UINT16_MAX : static_cast<uint16_t>(count);
+        }
+    };
+}
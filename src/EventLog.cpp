@@ -0,0 +1,378 @@
+#include <cstring>
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include "EventLog.h"
+
+namespace awml {
+
+    static const char s_LogMagic[8] = { 'A', 'W', 'M', 'L', 'L', 'O', 'G', '\0' };
+    static const uint32_t s_LogVersion = 1;
+
+    // Events the log grows by once the mapping is full.
+    static const uint64_t s_LogGrowth = 4096;
+
+    MappedFile::MappedFile()
+        : m_Data(nullptr),
+        m_Size(0),
+        m_Writable(false),
+    #ifdef _WIN32
+        m_File(INVALID_HANDLE_VALUE),
+        m_Mapping(NULL)
+    #else
+        m_Fd(-1)
+    #endif
+    {
+    }
+
+#ifdef _WIN32
+
+    bool MappedFile::Create(const std::string& path, size_t size)
+    {
+        Close();
+
+        m_File = CreateFileA(
+            path.c_str(),
+            GENERIC_READ | GENERIC_WRITE,
+            FILE_SHARE_READ,
+            NULL,
+            CREATE_ALWAYS,
+            FILE_ATTRIBUTE_NORMAL,
+            NULL
+        );
+
+        if (m_File == INVALID_HANDLE_VALUE)
+            return false;
+
+        m_Writable = true;
+        m_Size = size;
+
+        return Map();
+    }
+
+    bool MappedFile::Open(const std::string& path)
+    {
+        Close();
+
+        m_File = CreateFileA(
+            path.c_str(),
+            GENERIC_READ,
+            FILE_SHARE_READ,
+            NULL,
+            OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL,
+            NULL
+        );
+
+        LARGE_INTEGER size;
+
+        if (m_File == INVALID_HANDLE_VALUE || !GetFileSizeEx(m_File, &size))
+        {
+            Close();
+            return false;
+        }
+
+        m_Writable = false;
+        m_Size = static_cast<size_t>(size.QuadPart);
+
+        return Map();
+    }
+
+    bool MappedFile::Map()
+    {
+        if (!m_Size)
+        {
+            Close();
+            return false;
+        }
+
+        // A writable mapping larger than the file extends it.
+        m_Mapping = CreateFileMappingW(
+            m_File,
+            NULL,
+            m_Writable ? PAGE_READWRITE : PAGE_READONLY,
+            static_cast<DWORD>(static_cast<uint64_t>(m_Size) >> 32),
+            static_cast<DWORD>(m_Size),
+            NULL
+        );
+
+        if (m_Mapping)
+            m_Data = MapViewOfFile(
+                m_Mapping,
+                m_Writable ? FILE_MAP_WRITE : FILE_MAP_READ,
+                0, 0,
+                m_Size
+            );
+
+        if (!m_Data)
+        {
+            Close();
+            return false;
+        }
+
+        return true;
+    }
+
+    void MappedFile::Unmap()
+    {
+        if (m_Data)
+            UnmapViewOfFile(m_Data);
+
+        if (m_Mapping)
+            CloseHandle(m_Mapping);
+
+        m_Data = nullptr;
+        m_Mapping = NULL;
+    }
+
+    bool MappedFile::Resize(size_t size)
+    {
+        if (!m_Writable || !m_Data)
+            return false;
+
+        Unmap();
+        m_Size = size;
+
+        return Map();
+    }
+
+    void MappedFile::Close(size_t final_size)
+    {
+        Unmap();
+
+        if (m_File != INVALID_HANDLE_VALUE)
+        {
+            if (m_Writable && final_size != SIZE_MAX)
+            {
+                LARGE_INTEGER size;
+                size.QuadPart = static_cast<LONGLONG>(final_size);
+
+                if (SetFilePointerEx(m_File, size, NULL, FILE_BEGIN))
+                    SetEndOfFile(m_File);
+            }
+
+            CloseHandle(m_File);
+        }
+
+        m_File = INVALID_HANDLE_VALUE;
+        m_Size = 0;
+        m_Writable = false;
+    }
+
+#else
+
+    bool MappedFile::Create(const std::string& path, size_t size)
+    {
+        Close();
+
+        m_Fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+        if (m_Fd < 0 || ftruncate(m_Fd, static_cast<off_t>(size)))
+        {
+            Close();
+            return false;
+        }
+
+        m_Writable = true;
+        m_Size = size;
+
+        return Map();
+    }
+
+    bool MappedFile::Open(const std::string& path)
+    {
+        Close();
+
+        m_Fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+        struct stat info;
+
+        if (m_Fd < 0 || fstat(m_Fd, &info))
+        {
+            Close();
+            return false;
+        }
+
+        m_Writable = false;
+        m_Size = static_cast<size_t>(info.st_size);
+
+        return Map();
+    }
+
+    bool MappedFile::Map()
+    {
+        if (!m_Size)
+        {
+            Close();
+            return false;
+        }
+
+        void* data = mmap(
+            nullptr,
+            m_Size,
+            m_Writable ? PROT_READ | PROT_WRITE : PROT_READ,
+            MAP_SHARED,
+            m_Fd,
+            0
+        );
+
+        if (data == MAP_FAILED)
+        {
+            Close();
+            return false;
+        }
+
+        m_Data = data;
+
+        return true;
+    }
+
+    void MappedFile::Unmap()
+    {
+        if (m_Data)
+            munmap(m_Data, m_Size);
+
+        m_Data = nullptr;
+    }
+
+    bool MappedFile::Resize(size_t size)
+    {
+        if (!m_Writable || !m_Data)
+            return false;
+
+        Unmap();
+
+        if (ftruncate(m_Fd, static_cast<off_t>(size)))
+        {
+            Close();
+            return false;
+        }
+
+        m_Size = size;
+
+        return Map();
+    }
+
+    void MappedFile::Close(size_t final_size)
+    {
+        Unmap();
+
+        if (m_Fd >= 0)
+        {
+            if (m_Writable && final_size != SIZE_MAX)
+                (void)ftruncate(m_Fd, static_cast<off_t>(final_size));
+
+            close(m_Fd);
+        }
+
+        m_Fd = -1;
+        m_Size = 0;
+        m_Writable = false;
+    }
+
+#endif
+
+    MappedFile::~MappedFile()
+    {
+        Close();
+    }
+
+    EventRecorder::EventRecorder()
+        : m_Count(0),
+        m_Capacity(0)
+    {
+    }
+
+    bool EventRecorder::Start(const std::string& path, uint16_t width, uint16_t height)
+    {
+        Stop();
+
+        if (!m_File.Create(path, sizeof(EventLogHeader) + s_LogGrowth * sizeof(Event)))
+            return false;
+
+        EventLogHeader header = {};
+        memcpy(header.magic, s_LogMagic, sizeof(s_LogMagic));
+        header.version = s_LogVersion;
+        header.event_size = sizeof(Event);
+        header.width = width;
+        header.height = height;
+
+        memcpy(m_File.Data(), &header, sizeof(header));
+
+        m_Count = 0;
+        m_Capacity = s_LogGrowth;
+
+        return true;
+    }
+
+    bool EventRecorder::Grow()
+    {
+        if (!m_File.IsOpen())
+            return false;
+
+        // Doubling keeps the number of remaps logarithmic.
+        uint64_t capacity = m_Capacity * 2;
+
+        // Written first, so the events so far can be
+        // read back if the resize or the process fails.
+        reinterpret_cast<EventLogHeader*>(m_File.Data())->count = m_Count;
+
+        if (!m_File.Resize(sizeof(EventLogHeader) + capacity * sizeof(Event)))
+        {
+            m_Count = 0;
+            m_Capacity = 0;
+            return false;
+        }
+
+        m_Capacity = capacity;
+
+        return true;
+    }
+
+    void EventRecorder::Stop()
+    {
+        if (!m_File.IsOpen())
+            return;
+
+        // Also written by every Grow, an interrupted recording
+        // reads back up to the last time the log grew.
+        reinterpret_cast<EventLogHeader*>(m_File.Data())->count = m_Count;
+
+        m_File.Close(sizeof(EventLogHeader) + m_Count * sizeof(Event));
+
+        m_Count = 0;
+        m_Capacity = 0;
+    }
+
+    EventRecorder::~EventRecorder()
+    {
+        Stop();
+    }
+
+    std::string EventLogReader::Open(const std::string& path)
+    {
+        if (!m_File.Open(path))
+            return "Failed to open the event log!";
+
+        if (m_File.Size() < sizeof(EventLogHeader))
+            return "The event log is truncated!";
+
+        const auto& header = Header();
+
+        if (memcmp(header.magic, s_LogMagic, sizeof(s_LogMagic)))
+            return "The file is not an AWML event log!";
+
+        if (header.version != s_LogVersion || header.event_size != sizeof(Event))
+            return "The event log was recorded by an incompatible AWML version!";
+
+        if (m_File.Size() < sizeof(EventLogHeader) + header.count * sizeof(Event))
+            return "The event log is truncated!";
+
+        return std::string();
+    }
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#ifdef _WIN32
+    #include <windows.h>
+#endif
+
+#include <AWML/events.h>
+
+namespace awml {
+
+    // Layout of a recorded event log: this header followed by
+    // count Event records exactly as they are laid out in memory,
+    // so a log can only be replayed by a build with the same Event.
+    struct EventLogHeader
+    {
+        char     magic[8];
+        uint32_t version;
+        uint32_t event_size;
+        uint64_t count;
+
+        // Size of the window when the recording started.
+        uint16_t width;
+        uint16_t height;
+    };
+
+    // A memory mapping of a whole file.
+    class MappedFile
+    {
+    private:
+        void*  m_Data;
+        size_t m_Size;
+        bool   m_Writable;
+
+    #ifdef _WIN32
+        HANDLE m_File;
+        HANDLE m_Mapping;
+    #else
+        int m_Fd;
+    #endif
+    public:
+        MappedFile();
+
+        MappedFile(const MappedFile& other) = delete;
+        MappedFile& operator=(const MappedFile& other) = delete;
+
+        // Creates (or truncates) the file and maps size bytes of it.
+        bool Create(const std::string& path, size_t size);
+
+        // Maps an existing file read-only.
+        bool Open(const std::string& path);
+
+        // Grows or shrinks a file opened with Create, the
+        // mapping (and with it Data) may move.
+        bool Resize(size_t size);
+
+        // Unmaps the file, a created file is cut down to final_size.
+        void Close(size_t final_size = SIZE_MAX);
+
+        bool IsOpen() const { return m_Data != nullptr; }
+
+        uint8_t* Data() const { return static_cast<uint8_t*>(m_Data); }
+
+        size_t Size() const { return m_Size; }
+
+        ~MappedFile();
+    private:
+        bool Map();
+        void Unmap();
+    };
+
+    // Appends events to a memory mapped log, used by the windows
+    // to record the stream handed to their consumers. USER events
+    // aren't recorded, UserEvent::data points into the process
+    // that posted them and would dangle in a replay.
+    class EventRecorder
+    {
+    private:
+        MappedFile m_File;
+        uint64_t   m_Count;
+        uint64_t   m_Capacity;
+    public:
+        EventRecorder();
+
+        bool Start(const std::string& path, uint16_t width, uint16_t height);
+
+        bool IsRecording() const { return m_File.IsOpen(); }
+
+        // Returns false if the log couldn't grow, the
+        // recording is stopped with what was written so far.
+        bool Record(const Event& event)
+        {
+            if (event.type == EventType::USER)
+                return true;
+
+            if (m_Count == m_Capacity && !Grow())
+                return false;
+
+            reinterpret_cast<Event*>(m_File.Data() + sizeof(EventLogHeader))[m_Count++] = event;
+            return true;
+        }
+
+        void Stop();
+
+        ~EventRecorder();
+    private:
+        bool Grow();
+    };
+
+    // Read-only view of a recorded log.
+    class EventLogReader
+    {
+    private:
+        MappedFile m_File;
+    public:
+        // Returns an empty string on success, otherwise what went wrong.
+        std::string Open(const std::string& path);
+
+        const EventLogHeader& Header() const
+        {
+            return *reinterpret_cast<const EventLogHeader*>(m_File.Data());
+        }
+
+        const Event* Events() const
+        {
+            return reinterpret_cast<const Event*>(m_File.Data() + sizeof(EventLogHeader));
+        }
+
+        uint64_t Count() const { return Header().count; }
+    };
+}
@@ -0,0 +1,149 @@
+#include "EventWindow.h"
+
+namespace awml {
+
+    EventWindow::EventWindow()
+        : m_Events(),
+        m_ErrorCB(),
+        m_Callbacks(),
+        m_Input(),
+        m_TrackInput(false),
+        m_Recorder(),
+        m_Awaiters()
+    {
+    }
+
+    void EventWindow::PollEvents()
+    {
+        if (!BeginPoll())
+            return;
+
+        Dispatch();
+    }
+
+    size_t EventWindow::PollEvents(PollBudget budget)
+    {
+        if (!BeginPoll())
+            return 0;
+
+        // Before anything is pumped, so the coroutines
+        // of the previous frame start this one's events fresh.
+        m_Awaiters.ResumeFrame();
+
+        BudgetedDispatch dispatch(budget);
+        bool more;
+
+        do
+        {
+            more = PumpEvents();
+
+            dispatch.Run(
+                m_Events,
+                m_Callbacks,
+                [this](const Event& event) { ApplyEvent(event); }
+            );
+        } while (!dispatch.Exhausted() && more);
+
+        return BudgetedDispatch::Backlog(m_Events) + PendingEvents();
+    }
+
+    size_t EventWindow::DrainEvents(Event* out, size_t max)
+    {
+        if (!BeginPoll())
+            return 0;
+
+        m_Awaiters.ResumeFrame();
+
+        PumpEvents();
+
+        return PopEvents(out, max);
+    }
+
+    size_t EventWindow::DispatchPending()
+    {
+        if (!BeginDispatch())
+            return 0;
+
+        return Dispatch();
+    }
+
+    void EventWindow::OnError(error_callback cb)
+    {
+        m_ErrorCB = cb;
+    }
+
+    void EventWindow::NotifyError(error code, const std::string& message)
+    {
+        ReportError(m_ErrorCB, code, message);
+    }
+
+    const InputSnapshot& EventWindow::GetInputSnapshot()
+    {
+        return m_Input.Current();
+    }
+
+    InputSnapshot EventWindow::ReadInputSnapshot()
+    {
+        return m_Input.Read();
+    }
+
+    size_t EventWindow::PopEvents(Event* out, size_t max)
+    {
+        size_t count;
+        size_t kept = 0;
+
+        // Events already handled by a budgeted poll are left
+        // behind as NONE, skip over them.
+        while (!kept && (count = m_Events.Pop(out, max)))
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                if (out[i].type == EventType::NONE)
+                    continue;
+
+                ApplyEvent(out[i]);
+                out[kept++] = out[i];
+            }
+        }
+
+        return kept;
+    }
+
+    void EventWindow::ApplyEvent(const Event& event)
+    {
+        ApplyWindowState(event);
+
+        if (m_TrackInput)
+            m_Input.Apply(event);
+
+        if (m_Recorder.IsRecording() && !m_Recorder.Record(event))
+            NotifyError(error::GENERIC, "Failed to grow the event log, the recording stopped!");
+
+        m_Awaiters.ResumeEvent(event);
+    }
+
+    size_t EventWindow::Dispatch()
+    {
+        m_Awaiters.ResumeFrame();
+
+        Event batch[AWML_EVENT_BATCH_SIZE];
+        size_t dispatched = 0;
+        bool more;
+
+        do
+        {
+            more = PumpEvents();
+
+            size_t count;
+            while ((count = PopEvents(batch, AWML_EVENT_BATCH_SIZE)))
+            {
+                for (size_t i = 0; i < count; ++i)
+                    awml::DispatchEvent(m_Callbacks, batch[i]);
+
+                dispatched += count;
+            }
+        } while (more);
+
+        return dispatched;
+    }
+}
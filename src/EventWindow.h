@@ -0,0 +1,81 @@
+#pragma once
+
+#include <AWML/awml.h>
+
+#include "AwaitQueue.h"
+#include "BudgetedDispatch.h"
+#include "CallbackHandler.h"
+#include "EventCoalescer.h"
+#include "EventLog.h"
+#include "InputTracker.h"
+#include "utilities.h"
+
+namespace awml {
+
+    // The consuming side of the event loop, shared by the backends.
+    // A backend pumps its events into m_Events, handing them out from
+    // there and dispatching them to the callbacks is done here.
+    class EventWindow : public Window
+    {
+    protected:
+        EventQueue m_Events;
+
+        error_callback m_ErrorCB;
+
+        CallbackHandler m_Callbacks;
+
+        // Fed by ApplyEvent when set, backends that keep it up
+        // to date as they decode leave it off.
+        InputTracker m_Input;
+        bool         m_TrackInput;
+
+        EventRecorder m_Recorder;
+
+        AwaitQueue m_Awaiters;
+    public:
+        using Window::PollEvents;
+        void PollEvents() override;
+
+        size_t PollEvents(PollBudget budget) override;
+
+        size_t DrainEvents(Event* out, size_t max) override;
+
+        size_t DispatchPending() override;
+
+        void OnError(error_callback cb) override;
+
+        const InputSnapshot& GetInputSnapshot() override;
+        InputSnapshot ReadInputSnapshot() override;
+    protected:
+        EventWindow();
+
+        virtual void NotifyError(error code, const std::string& message);
+
+        // Called before the queue is consumed by the polls,
+        // false skips them if the window can't be used.
+        virtual bool BeginPoll() = 0;
+
+        // The same for DispatchPending.
+        virtual bool BeginDispatch() { return BeginPoll(); }
+
+        // Moves what the system has for the window into m_Events.
+        // Returns true if more may be waiting behind a full queue.
+        virtual bool PumpEvents() = 0;
+
+        // Events held outside of m_Events, added
+        // to the backlog of a budgeted poll.
+        virtual size_t PendingEvents() { return 0; }
+
+        // Window state the backend keeps, updated on the consuming
+        // side so it never runs ahead of the events handed out.
+        virtual void ApplyWindowState(const Event&) {}
+
+        size_t PopEvents(Event* out, size_t max);
+    private:
+        void ApplyEvent(const Event& event);
+
+        // Pumps and dispatches until nothing is left, returns the
+        // number of events dispatched.
+        size_t Dispatch();
+    };
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include <AWML/awml.h>
+
+namespace awml {
+
+    // Keeps the CPU at most a few frames ahead of the GPU. A fence
+    // goes in behind every swap, and once too many are pending the
+    // swap waits for the oldest one, so the driver can't queue up
+    // frames whose input is stale by the time they're shown. Only
+    // touched from the thread the context is current on. Fences
+    // still pending when the context goes die with it.
+    class FrameFences
+    {
+    public:
+        static constexpr uint32_t s_MaxFrames = 8;
+    private:
+        GLsync   m_Fences[s_MaxFrames];
+        uint32_t m_Oldest;
+        uint32_t m_Pending;
+
+        // 0 when off.
+        uint32_t m_Limit;
+
+        // Read by other threads while the render thread swaps.
+        std::atomic<int64_t> m_LastWait;
+    public:
+        FrameFences()
+            : m_Fences(),
+            m_Oldest(0),
+            m_Pending(0),
+            m_Limit(0),
+            m_LastWait(0)
+        {
+        }
+
+        FrameFences(const FrameFences& other) = delete;
+        FrameFences& operator=(const FrameFences& other) = delete;
+
+        // Sync objects are core since 3.2, before that
+        // the entry points may not have been loaded.
+        static bool Supported()
+        {
+            return glFenceSync && glClientWaitSync && glDeleteSync;
+        }
+
+        // Deletes the pending fences, the context has to be current.
+        void SetLimit(uint32_t frames)
+        {
+            for (; m_Pending; --m_Pending, m_Oldest = (m_Oldest + 1) % s_MaxFrames)
+                glDeleteSync(m_Fences[m_Oldest]);
+
+            m_Oldest = 0;
+            m_Limit = frames;
+            m_LastWait.store(0, std::memory_order_relaxed);
+        }
+
+        // Call right after the swap. Returns false if
+        // the driver failed a wait, the fence is dropped.
+        bool EndFrame()
+        {
+            if (!m_Limit)
+                return true;
+
+            GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+            if (fence)
+            {
+                m_Fences[(m_Oldest + m_Pending) % s_MaxFrames] = fence;
+                ++m_Pending;
+            }
+
+            // Counting the frame the CPU is about to record.
+            bool ok = true;
+            auto start = std::chrono::steady_clock::now();
+
+            while (m_Pending && m_Pending >= m_Limit)
+            {
+                GLsync oldest = m_Fences[m_Oldest];
+
+                // The flush makes sure the fence is submitted, or the
+                // wait could outlast the timeout for nothing.
+                GLenum status = glClientWaitSync(
+                    oldest,
+                    GL_SYNC_FLUSH_COMMANDS_BIT,
+                    std::chrono::nanoseconds(std::chrono::seconds(1)).count()
+                );
+
+                // A timeout is a hung GPU, which waiting longer won't fix.
+                if (status == GL_WAIT_FAILED)
+                    ok = false;
+
+                glDeleteSync(oldest);
+
+                m_Oldest = (m_Oldest + 1) % s_MaxFrames;
+                --m_Pending;
+            }
+
+            m_LastWait.store(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start
+                ).count(),
+                std::memory_order_relaxed
+            );
+
+            return ok;
+        }
+
+        std::chrono::nanoseconds LastWait() const
+        {
+            return std::chrono::nanoseconds(m_LastWait.load(std::memory_order_relaxed));
+        }
+    };
+}
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+
+#ifdef _WIN32
+  #include <windows.h>
+
+  #ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+    #define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+  #endif
+#else
+  #include <cerrno>
+  #include <time.h>
+#endif
+
+#include <AWML/awml.h>
+
+namespace awml {
+
+    // Paces a frame loop to a fixed rate without vsync. Sleeps until
+    // shortly before the deadline and spins the rest of the way, the
+    // margin follows how late the sleeps wake up. Deadlines advance
+    // by the period from the previous one, so wake-up errors don't
+    // accumulate into drift.
+    class FrameLimiter
+    {
+    private:
+        typedef std::chrono::steady_clock clock;
+
+        std::chrono::nanoseconds m_Period;
+        clock::time_point        m_Deadline;
+        clock::time_point        m_LastFrame;
+
+        // Average of how late sleeps wake up.
+        std::chrono::nanoseconds m_Oversleep;
+
+        // Frame time statistics, Welford's running variance.
+        uint64_t m_Frames;
+        double   m_Mean;
+        double   m_M2;
+        double   m_MaxDeviation;
+
+#ifdef _WIN32
+        HANDLE m_Timer;
+#endif
+    public:
+        FrameLimiter()
+            : m_Period(std::chrono::nanoseconds::zero()),
+            m_Deadline(),
+            m_LastFrame(),
+            m_Oversleep(std::chrono::microseconds(100)),
+            m_Frames(0),
+            m_Mean(0.0),
+            m_M2(0.0),
+            m_MaxDeviation(0.0)
+        {
+#ifdef _WIN32
+            // High resolution timers exist since Windows 10 1803.
+            m_Timer = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+
+            if (!m_Timer)
+                m_Timer = CreateWaitableTimerExW(NULL, NULL, 0, TIMER_ALL_ACCESS);
+#endif
+        }
+
+        FrameLimiter(const FrameLimiter& other) = delete;
+        FrameLimiter& operator=(const FrameLimiter& other) = delete;
+
+        bool Enabled() const { return m_Period.count() > 0; }
+
+        std::chrono::nanoseconds Period() const { return m_Period; }
+
+        // 0 or less turns the limiter off, the statistics start over.
+        void SetRate(double hz)
+        {
+            m_Period = hz > 0.0 ?
+                std::chrono::nanoseconds(static_cast<int64_t>(1e9 / hz)) :
+                std::chrono::nanoseconds::zero();
+
+            m_Deadline = clock::time_point();
+            m_LastFrame = clock::time_point();
+
+            m_Frames = 0;
+            m_Mean = 0.0;
+            m_M2 = 0.0;
+            m_MaxDeviation = 0.0;
+        }
+
+        // Returns at the next frame deadline.
+        void Wait()
+        {
+            if (!Enabled())
+                return;
+
+            auto now = clock::now();
+
+            if (m_Deadline == clock::time_point())
+                m_Deadline = now;
+
+            // Spun away before the deadline, twice the usual
+            // oversleep but between 50us and 2ms.
+            std::chrono::nanoseconds margin = m_Oversleep * 2;
+            margin = (std::max)(margin, std::chrono::nanoseconds(std::chrono::microseconds(50)));
+            margin = (std::min)(margin, std::chrono::nanoseconds(std::chrono::milliseconds(2)));
+
+            auto wake = m_Deadline - margin;
+
+            if (now < wake)
+            {
+                SleepUntil(wake);
+
+                auto late = clock::now() - wake;
+                m_Oversleep = (m_Oversleep * 7 + std::chrono::duration_cast<std::chrono::nanoseconds>(late)) / 8;
+            }
+
+            while (clock::now() < m_Deadline)
+                std::this_thread::yield();
+
+            now = clock::now();
+            Record(now);
+
+            m_Deadline += m_Period;
+
+            // A frame that took more than a whole period restarts the
+            // schedule, catching up would burst frames out unpaced.
+            if (now > m_Deadline)
+                m_Deadline = now;
+        }
+
+        FramePacingStats Stats() const
+        {
+            FramePacingStats stats;
+            stats.frames = m_Frames;
+            stats.target = m_Period;
+            stats.mean_frame_time = std::chrono::nanoseconds(static_cast<int64_t>(m_Mean));
+            stats.jitter = std::chrono::nanoseconds(
+                static_cast<int64_t>(m_Frames > 1 ? std::sqrt(m_M2 / (m_Frames - 1)) : 0.0)
+            );
+            stats.max_deviation = std::chrono::nanoseconds(static_cast<int64_t>(m_MaxDeviation));
+
+            return stats;
+        }
+
+        ~FrameLimiter()
+        {
+#ifdef _WIN32
+            if (m_Timer)
+                CloseHandle(m_Timer);
+#endif
+        }
+    private:
+        void Record(clock::time_point now)
+        {
+            if (m_LastFrame != clock::time_point())
+            {
+                double frame_time = static_cast<double>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_LastFrame).count()
+                );
+
+                ++m_Frames;
+
+                double delta = frame_time - m_Mean;
+                m_Mean += delta / m_Frames;
+                m_M2 += delta * (frame_time - m_Mean);
+
+                m_MaxDeviation = (std::max)(
+                    m_MaxDeviation,
+                    std::abs(frame_time - static_cast<double>(m_Period.count()))
+                );
+            }
+
+            m_LastFrame = now;
+        }
+
+        void SleepUntil(clock::time_point until)
+        {
+#ifdef _WIN32
+            auto delay = std::chrono::duration_cast<std::chrono::nanoseconds>(until - clock::now());
+
+            if (!m_Timer || delay.count() <= 0)
+                return;
+
+            // Relative, in 100ns units.
+            LARGE_INTEGER due;
+            due.QuadPart = -static_cast<LONGLONG>(delay.count() / 100);
+
+            if (SetWaitableTimer(m_Timer, &due, 0, NULL, NULL, FALSE))
+                WaitForSingleObject(m_Timer, INFINITE);
+#else
+            // steady_clock is CLOCK_MONOTONIC, an absolute
+            // deadline isn't pushed back by interruptions.
+            auto since_epoch = std::chrono::duration_cast<std::chrono::nanoseconds>(until.time_since_epoch());
+
+            timespec deadline;
+            deadline.tv_sec = static_cast<time_t>(since_epoch.count() / 1000000000);
+            deadline.tv_nsec = static_cast<long>(since_epoch.count() % 1000000000);
+
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR)
+                ;
+#endif
+        }
+    };
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdio>
+#include <cstring>
+
+#include <AWML/awml.h>
+
+namespace awml {
+
+    // Whether a space separated extension string contains name,
+    // names can be prefixes of others so only whole words count.
+    inline bool HasExtension(const char* extensions, const char* name)
+    {
+        size_t length = strlen(name);
+
+        for (const char* at = extensions; at && (at = strstr(at, name)); at += length)
+        {
+            if ((at == extensions || at[-1] == ' ') && (at[length] == ' ' || at[length] == '\0'))
+                return true;
+        }
+
+        return false;
+    }
+
+    // Parses the "major.minor" prefix of a GL_VERSION string,
+    // the versions stay 0 if there is none.
+    inline void ParseGLVersion(const GLubyte* version, int& major, int& minor)
+    {
+        major = 0;
+        minor = 0;
+
+        if (version)
+            sscanf(reinterpret_cast<const char*>(version), "%d.%d", &major, &minor);
+    }
+
+    // Reads the attributes of the context current on the calling
+    // thread, glGetIntegerv has to be loaded already.
+    inline ContextConfig QueryContextConfig()
+    {
+        int major;
+        int minor;
+        ParseGLVersion(glGetString(GL_VERSION), major, minor);
+
+        ContextConfig config;
+        config.major = static_cast<uint8_t>(major);
+        config.minor = static_cast<uint8_t>(minor);
+
+        // Context flags exist since 3.0, profiles since 3.2.
+        if (major >= 3)
+        {
+            GLint flags = 0;
+            glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
+
+            config.debug              = (flags & GL_CONTEXT_FLAG_DEBUG_BIT) != 0;
+            config.forward_compatible = (flags & GL_CONTEXT_FLAG_FORWARD_COMPATIBLE_BIT) != 0;
+            config.no_error           = (flags & GL_CONTEXT_FLAG_NO_ERROR_BIT) != 0;
+            config.robust             = (flags & GL_CONTEXT_FLAG_ROBUST_ACCESS_BIT) != 0;
+        }
+
+        if (major > 3 || (major == 3 && minor >= 2))
+        {
+            GLint mask = 0;
+            glGetIntegerv(GL_CONTEXT_PROFILE_MASK, &mask);
+
+            if (mask & GL_CONTEXT_CORE_PROFILE_BIT)
+                config.profile = GLProfile::CORE;
+            else if (mask & GL_CONTEXT_COMPATIBILITY_PROFILE_BIT)
+                config.profile = GLProfile::COMPATIBILITY;
+        }
+
+        return config;
+    }
+}
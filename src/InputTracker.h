@@ -0,0 +1,181 @@
+#pragma once
+
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+#include <AWML/events.h>
+#include <AWML/input.h>
+
+namespace awml {
+
+    // Builds the InputSnapshot of the next frame from the consumed
+    // events and publishes it into one of two buffers, readers always
+    // see the last published one. Apply and Publish are only called
+    // by the thread that polls the window.
+    class InputTracker
+    {
+    private:
+        InputSnapshot m_Frames[2];
+        std::atomic<uint8_t> m_Current;
+
+        // Per buffer, odd while Publish writes it, so Read
+        // can tell that its copy overlapped a write.
+        std::atomic<uint32_t> m_Sequence[2];
+
+        // Transitions seen in the events since the last publish,
+        // so a press and release within one frame isn't lost.
+        KeySet m_Pressed;
+        KeySet m_Released;
+
+        uint16_t m_MouseX;
+        uint16_t m_MouseY;
+        int32_t  m_ScrollX;
+        int32_t  m_ScrollY;
+
+        wchar_t m_Text[AWML_TEXT_INPUT_SIZE];
+        uint8_t m_TextLength;
+    public:
+        InputTracker()
+            : m_Frames(),
+            m_Current(0),
+            m_Sequence(),
+            m_Pressed(),
+            m_Released(),
+            m_MouseX(0),
+            m_MouseY(0),
+            m_ScrollX(0),
+            m_ScrollY(0),
+            m_Text(),
+            m_TextLength(0)
+        {
+        }
+
+        // The event types that contribute to a snapshot.
+        static constexpr event_mask Mask()
+        {
+            return
+                EventBit(EventType::KEY_PRESSED)    |
+                EventBit(EventType::KEY_RELEASED)   |
+                EventBit(EventType::MOUSE_MOVED)    |
+                EventBit(EventType::MOUSE_PRESSED)  |
+                EventBit(EventType::MOUSE_RELEASED) |
+                EventBit(EventType::MOUSE_SCROLLED) |
+                EventBit(EventType::CHAR_TYPED);
+        }
+
+        void Apply(const Event& event)
+        {
+            switch (event.type)
+            {
+            case EventType::KEY_PRESSED:
+                if (!event.key.repeated)
+                    m_Pressed.Set(event.key.key);
+                break;
+            case EventType::KEY_RELEASED:
+                m_Released.Set(event.key.key);
+                break;
+            case EventType::MOUSE_PRESSED:
+                m_Pressed.Set(event.button.button);
+                break;
+            case EventType::MOUSE_RELEASED:
+                m_Released.Set(event.button.button);
+                break;
+            case EventType::MOUSE_MOVED:
+                m_MouseX = event.mouse.x;
+                m_MouseY = event.mouse.y;
+                break;
+            case EventType::MOUSE_SCROLLED:
+                if (event.scroll.vertical)
+                    m_ScrollY += event.scroll.delta;
+                else
+                    m_ScrollX += event.scroll.delta;
+                break;
+            case EventType::CHAR_TYPED:
+                if (m_TextLength < AWML_TEXT_INPUT_SIZE)
+                    m_Text[m_TextLength++] = event.text.character;
+                break;
+            default:
+                break;
+            }
+        }
+
+        // Publishes the next snapshot given the current key state.
+        // The edges are the XOR of the previous and the current
+        // state, which also covers state that changed without an
+        // event (e.g. keys dropped on focus loss).
+        const InputSnapshot& Publish(const KeySet& down)
+        {
+            uint8_t current = m_Current.load(std::memory_order_relaxed);
+
+            const InputSnapshot& prev = m_Frames[current];
+            InputSnapshot& next = m_Frames[current ^ 1];
+
+            uint32_t sequence = m_Sequence[current ^ 1].load(std::memory_order_relaxed);
+            m_Sequence[current ^ 1].store(sequence + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+
+            for (size_t i = 0; i < KeySet::s_Words; ++i)
+            {
+                uint64_t changed = prev.down.bits[i] ^ down.bits[i];
+
+                next.down.bits[i] = down.bits[i];
+                next.pressed.bits[i] = (changed & down.bits[i]) | m_Pressed.bits[i];
+                next.released.bits[i] = (changed & prev.down.bits[i]) | m_Released.bits[i];
+            }
+
+            next.frame = prev.frame + 1;
+
+            next.mouse_x = m_MouseX;
+            next.mouse_y = m_MouseY;
+            next.mouse_dx = static_cast<int32_t>(m_MouseX) - prev.mouse_x;
+            next.mouse_dy = static_cast<int32_t>(m_MouseY) - prev.mouse_y;
+
+            next.scroll_x = m_ScrollX;
+            next.scroll_y = m_ScrollY;
+
+            memcpy(next.text, m_Text, m_TextLength * sizeof(wchar_t));
+            next.text_length = m_TextLength;
+
+            m_Pressed = KeySet();
+            m_Released = KeySet();
+            m_ScrollX = 0;
+            m_ScrollY = 0;
+            m_TextLength = 0;
+
+            m_Sequence[current ^ 1].store(sequence + 2, std::memory_order_release);
+            m_Current.store(current ^ 1, std::memory_order_release);
+
+            return next;
+        }
+
+        const InputSnapshot& Current() const
+        {
+            return m_Frames[m_Current.load(std::memory_order_acquire)];
+        }
+
+        // A copy of the current snapshot from any thread, retried
+        // if a Publish started rewriting it during the copy.
+        InputSnapshot Read() const
+        {
+            InputSnapshot copy;
+
+            for (;;)
+            {
+                uint8_t current = m_Current.load(std::memory_order_acquire);
+                uint32_t before = m_Sequence[current].load(std::memory_order_acquire);
+
+                if (!(before & 1))
+                {
+                    memcpy(&copy, &m_Frames[current], sizeof(copy));
+                    std::atomic_thread_fence(std::memory_order_acquire);
+
+                    if (m_Sequence[current].load(std::memory_order_relaxed) == before)
+                        return copy;
+                }
+
+                std::this_thread::yield();
+            }
+        }
+    };
+}
@@ -0,0 +1,314 @@
+#pragma once
+
+#include <cstdint>
+
+#include <AWML/key_codes.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+#elif defined(__linux__)
+    #include <X11/keysym.h>
+#endif
+
+namespace awml {
+
+    template<typename Native>
+    struct KeyMapping
+    {
+        awml_key key;
+        Native   native;
+    };
+
+    // The native code of every awml_key, 0 where
+    // a key has no native counterpart.
+    template<typename Native>
+    struct NativeKeyTable
+    {
+        Native native[AWML_KEY_COUNT];
+
+        constexpr Native operator[](awml_key key) const
+        {
+            return native[static_cast<size_t>(key)];
+        }
+    };
+
+    template<typename Native, size_t N>
+    constexpr NativeKeyTable<Native> BuildNativeKeyTable(const KeyMapping<Native> (&mappings)[N])
+    {
+        NativeKeyTable<Native> table{};
+
+        for (size_t i = 0; i < N; ++i)
+            table.native[static_cast<size_t>(mappings[i].key)] = mappings[i].native;
+
+        return table;
+    }
+
+#ifdef _WIN32
+
+    constexpr KeyMapping<uint8_t> s_VirtualKeys[] =
+    {
+        { awml_key::MOUSE_LEFT,   VK_LBUTTON   },
+        { awml_key::MOUSE_RIGHT,  VK_RBUTTON   },
+        { awml_key::MOUSE_MIDDLE, VK_MBUTTON   },
+        { awml_key::MOUSE_X1,     VK_XBUTTON1  },
+        { awml_key::MOUSE_X2,     VK_XBUTTON2  },
+
+        { awml_key::LEFT,         VK_LEFT      },
+        { awml_key::UP,           VK_UP        },
+        { awml_key::RIGHT,        VK_RIGHT     },
+        { awml_key::DOWN,         VK_DOWN      },
+
+        { awml_key::_0,           0x30         },
+        { awml_key::_1,           0x31         },
+        { awml_key::_2,           0x32         },
+        { awml_key::_3,           0x33         },
+        { awml_key::_4,           0x34         },
+        { awml_key::_5,           0x35         },
+        { awml_key::_6,           0x36         },
+        { awml_key::_7,           0x37         },
+        { awml_key::_8,           0x38         },
+        { awml_key::_9,           0x39         },
+
+        { awml_key::A,            0x41         },
+        { awml_key::B,            0x42         },
+        { awml_key::C,            0x43         },
+        { awml_key::D,            0x44         },
+        { awml_key::E,            0x45         },
+        { awml_key::F,            0x46         },
+        { awml_key::G,            0x47         },
+        { awml_key::H,            0x48         },
+        { awml_key::I,            0x49         },
+        { awml_key::J,            0x4A         },
+        { awml_key::K,            0x4B         },
+        { awml_key::L,            0x4C         },
+        { awml_key::M,            0x4D         },
+        { awml_key::N,            0x4E         },
+        { awml_key::O,            0x4F         },
+        { awml_key::P,            0x50         },
+        { awml_key::Q,            0x51         },
+        { awml_key::R,            0x52         },
+        { awml_key::S,            0x53         },
+        { awml_key::T,            0x54         },
+        { awml_key::U,            0x55         },
+        { awml_key::V,            0x56         },
+        { awml_key::W,            0x57         },
+        { awml_key::X,            0x58         },
+        { awml_key::Y,            0x59         },
+        { awml_key::Z,            0x5A         },
+
+        { awml_key::F1,           VK_F1        },
+        { awml_key::F2,           VK_F2        },
+        { awml_key::F3,           VK_F3        },
+        { awml_key::F4,           VK_F4        },
+        { awml_key::F5,           VK_F5        },
+        { awml_key::F6,           VK_F6        },
+        { awml_key::F7,           VK_F7        },
+        { awml_key::F8,           VK_F8        },
+        { awml_key::F9,           VK_F9        },
+        { awml_key::F10,          VK_F10       },
+        { awml_key::F11,          VK_F11       },
+        { awml_key::F12,          VK_F12       },
+
+        { awml_key::LEFT_SHIFT,   VK_LSHIFT    },
+        { awml_key::RIGHT_SHIFT,  VK_RSHIFT    },
+        { awml_key::LEFT_CTRL,    VK_LCONTROL  },
+        { awml_key::RIGHT_CTRL,   VK_RCONTROL  },
+        { awml_key::LEFT_ALT,     VK_LMENU     },
+        { awml_key::RIGHT_ALT,    VK_RMENU     },
+
+        { awml_key::BACKSPACE,    VK_BACK      },
+        { awml_key::TAB,          VK_TAB       },
+        { awml_key::ENTER,        VK_RETURN    },
+        { awml_key::PAUSE,        VK_PAUSE     },
+        { awml_key::CAPSLOCK,     VK_CAPITAL   },
+        { awml_key::ESCAPE,       VK_ESCAPE    },
+        { awml_key::SPACEBAR,     VK_SPACE     },
+        { awml_key::PAGEUP,       VK_PRIOR     },
+        { awml_key::PAGEDOWN,     VK_NEXT      },
+        { awml_key::END,          VK_END       },
+        { awml_key::HOME,         VK_HOME      },
+        { awml_key::PRINTSCREEN,  VK_SNAPSHOT  },
+        { awml_key::INSERT,       VK_INSERT    },
+        { awml_key::DEL,          VK_DELETE    },
+        { awml_key::NUMLOCK,      VK_NUMLOCK   },
+        { awml_key::SCRLLOCK,     VK_SCROLL    },
+
+        { awml_key::NP_0,         VK_NUMPAD0   },
+        { awml_key::NP_1,         VK_NUMPAD1   },
+        { awml_key::NP_2,         VK_NUMPAD2   },
+        { awml_key::NP_3,         VK_NUMPAD3   },
+        { awml_key::NP_4,         VK_NUMPAD4   },
+        { awml_key::NP_5,         VK_NUMPAD5   },
+        { awml_key::NP_6,         VK_NUMPAD6   },
+        { awml_key::NP_7,         VK_NUMPAD7   },
+        { awml_key::NP_8,         VK_NUMPAD8   },
+        { awml_key::NP_9,         VK_NUMPAD9   },
+        { awml_key::NP_MULTIPLY,  VK_MULTIPLY  },
+        { awml_key::NP_ADD,       VK_ADD       },
+        { awml_key::NP_SEPARATOR, VK_SEPARATOR },
+        { awml_key::NP_SUBTRACT,  VK_SUBTRACT  },
+        { awml_key::NP_DECIMAL,   VK_DECIMAL   },
+        { awml_key::NP_DIVIDE,    VK_DIVIDE    },
+
+        { awml_key::SUPER_LEFT,   VK_LWIN      },
+        { awml_key::SUPER_RIGHT,  VK_RWIN      },
+    };
+
+    // awml_key -> VK_*
+    constexpr auto s_VirtualKeyTable = BuildNativeKeyTable(s_VirtualKeys);
+
+    // VK_* -> awml_key
+    struct AWMLKeyTable
+    {
+        awml_key key[256];
+
+        constexpr awml_key operator[](size_t native) const
+        {
+            return native < 256 ? key[native] : awml_key::UNKNOWN;
+        }
+    };
+
+    constexpr AWMLKeyTable BuildVirtualKeyLookup()
+    {
+        AWMLKeyTable table{};
+
+        for (const auto& mapping : s_VirtualKeys)
+            table.key[mapping.native] = mapping.key;
+
+        // The generic modifiers map to the left variant,
+        // WindowsWindow resolves the side where it can.
+        table.key[VK_SHIFT]   = awml_key::LEFT_SHIFT;
+        table.key[VK_CONTROL] = awml_key::LEFT_CTRL;
+        table.key[VK_MENU]    = awml_key::LEFT_ALT;
+
+        return table;
+    }
+
+    constexpr AWMLKeyTable s_VirtualKeyLookup = BuildVirtualKeyLookup();
+
+#elif defined(__linux__)
+
+    // Keys are matched against the unshifted, lower
+    // case KeySym of a keycode. The numpad digits are
+    // only found at the NumLock level, which is checked
+    // when nothing matches the base level.
+    constexpr KeyMapping<uint32_t> s_XKeySyms[] =
+    {
+        { awml_key::LEFT,         XK_Left         },
+        { awml_key::UP,           XK_Up           },
+        { awml_key::RIGHT,        XK_Right        },
+        { awml_key::DOWN,         XK_Down         },
+
+        { awml_key::_0,           XK_0            },
+        { awml_key::_1,           XK_1            },
+        { awml_key::_2,           XK_2            },
+        { awml_key::_3,           XK_3            },
+        { awml_key::_4,           XK_4            },
+        { awml_key::_5,           XK_5            },
+        { awml_key::_6,           XK_6            },
+        { awml_key::_7,           XK_7            },
+        { awml_key::_8,           XK_8            },
+        { awml_key::_9,           XK_9            },
+
+        { awml_key::A,            XK_a            },
+        { awml_key::B,            XK_b            },
+        { awml_key::C,            XK_c            },
+        { awml_key::D,            XK_d            },
+        { awml_key::E,            XK_e            },
+        { awml_key::F,            XK_f            },
+        { awml_key::G,            XK_g            },
+        { awml_key::H,            XK_h            },
+        { awml_key::I,            XK_i            },
+        { awml_key::J,            XK_j            },
+        { awml_key::K,            XK_k            },
+        { awml_key::L,            XK_l            },
+        { awml_key::M,            XK_m            },
+        { awml_key::N,            XK_n            },
+        { awml_key::O,            XK_o            },
+        { awml_key::P,            XK_p            },
+        { awml_key::Q,            XK_q            },
+        { awml_key::R,            XK_r            },
+        { awml_key::S,            XK_s            },
+        { awml_key::T,            XK_t            },
+        { awml_key::U,            XK_u            },
+        { awml_key::V,            XK_v            },
+        { awml_key::W,            XK_w            },
+        { awml_key::X,            XK_x            },
+        { awml_key::Y,            XK_y            },
+        { awml_key::Z,            XK_z            },
+
+        { awml_key::F1,           XK_F1           },
+        { awml_key::F2,           XK_F2           },
+        { awml_key::F3,           XK_F3           },
+        { awml_key::F4,           XK_F4           },
+        { awml_key::F5,           XK_F5           },
+        { awml_key::F6,           XK_F6           },
+        { awml_key::F7,           XK_F7           },
+        { awml_key::F8,           XK_F8           },
+        { awml_key::F9,           XK_F9           },
+        { awml_key::F10,          XK_F10          },
+        { awml_key::F11,          XK_F11          },
+        { awml_key::F12,          XK_F12          },
+
+        { awml_key::LEFT_SHIFT,   XK_Shift_L      },
+        { awml_key::RIGHT_SHIFT,  XK_Shift_R      },
+        { awml_key::LEFT_CTRL,    XK_Control_L    },
+        { awml_key::RIGHT_CTRL,   XK_Control_R    },
+        { awml_key::LEFT_ALT,     XK_Alt_L        },
+        { awml_key::RIGHT_ALT,    XK_Alt_R        },
+
+        { awml_key::BACKSPACE,    XK_BackSpace    },
+        { awml_key::TAB,          XK_Tab          },
+        { awml_key::ENTER,        XK_Return       },
+        { awml_key::PAUSE,        XK_Pause        },
+        { awml_key::CAPSLOCK,     XK_Caps_Lock    },
+        { awml_key::ESCAPE,       XK_Escape       },
+        { awml_key::SPACEBAR,     XK_space        },
+        { awml_key::PAGEUP,       XK_Page_Up      },
+        { awml_key::PAGEDOWN,     XK_Page_Down    },
+        { awml_key::END,          XK_End          },
+        { awml_key::HOME,         XK_Home         },
+        { awml_key::PRINTSCREEN,  XK_Print        },
+        { awml_key::INSERT,       XK_Insert       },
+        { awml_key::DEL,          XK_Delete       },
+        { awml_key::NUMLOCK,      XK_Num_Lock     },
+        { awml_key::SCRLLOCK,     XK_Scroll_Lock  },
+
+        { awml_key::NP_0,         XK_KP_0         },
+        { awml_key::NP_1,         XK_KP_1         },
+        { awml_key::NP_2,         XK_KP_2         },
+        { awml_key::NP_3,         XK_KP_3         },
+        { awml_key::NP_4,         XK_KP_4         },
+        { awml_key::NP_5,         XK_KP_5         },
+        { awml_key::NP_6,         XK_KP_6         },
+        { awml_key::NP_7,         XK_KP_7         },
+        { awml_key::NP_8,         XK_KP_8         },
+        { awml_key::NP_9,         XK_KP_9         },
+        { awml_key::NP_MULTIPLY,  XK_KP_Multiply  },
+        { awml_key::NP_ADD,       XK_KP_Add       },
+        { awml_key::NP_SEPARATOR, XK_KP_Separator },
+        { awml_key::NP_SUBTRACT,  XK_KP_Subtract  },
+        { awml_key::NP_DECIMAL,   XK_KP_Decimal   },
+        { awml_key::NP_DIVIDE,    XK_KP_Divide    },
+
+        { awml_key::SUPER_LEFT,   XK_Super_L      },
+        { awml_key::SUPER_RIGHT,  XK_Super_R      },
+    };
+
+    // X pointer button -> awml_key, 4 to 7 are the scroll wheel.
+    constexpr awml_key s_XButtons[] =
+    {
+        awml_key::UNKNOWN,
+        awml_key::MOUSE_LEFT,
+        awml_key::MOUSE_MIDDLE,
+        awml_key::MOUSE_RIGHT,
+        awml_key::UNKNOWN,
+        awml_key::UNKNOWN,
+        awml_key::UNKNOWN,
+        awml_key::UNKNOWN,
+        awml_key::MOUSE_X1,
+        awml_key::MOUSE_X2
+    };
+
+#endif
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace awml {
+
+    // A fixed capacity multi-producer/single-consumer queue.
+    // Any thread can Push, Pop is only ever called from one
+    // thread. Every slot carries a sequence number that tells
+    // producers and the consumer whose turn it is, so no locks
+    // are taken and items come out in the order they were claimed.
+    template<typename T, size_t Capacity>
+    class MPSCQueue
+    {
+    private:
+        static_assert(
+            Capacity && !(Capacity & (Capacity - 1)),
+            "MPSCQueue capacity has to be a power of two"
+        );
+
+        static_assert(
+            std::is_trivially_copyable<T>::value,
+            "MPSCQueue can only hold trivially copyable types"
+        );
+
+        static constexpr size_t s_Mask = Capacity - 1;
+
+        struct Slot
+        {
+            std::atomic<size_t> sequence;
+            T                   item;
+        };
+
+        alignas(64) std::atomic<size_t> m_Head;
+        alignas(64) size_t              m_Tail;
+
+        alignas(64) Slot m_Slots[Capacity];
+    public:
+        MPSCQueue()
+            : m_Head(0),
+            m_Tail(0)
+        {
+            for (size_t i = 0; i < Capacity; ++i)
+                m_Slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        MPSCQueue(const MPSCQueue& other) = delete;
+        MPSCQueue& operator=(const MPSCQueue& other) = delete;
+
+        bool Push(const T& item)
+        {
+            size_t head = m_Head.load(std::memory_order_relaxed);
+            Slot* slot;
+
+            for (;;)
+            {
+                slot = &m_Slots[head & s_Mask];
+
+                auto sequence = slot->sequence.load(std::memory_order_acquire);
+                auto distance = static_cast<intptr_t>(sequence - head);
+
+                if (distance == 0)
+                {
+                    if (m_Head.compare_exchange_weak(head, head + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (distance < 0)
+                {
+                    // The consumer hasn't freed this slot yet.
+                    return false;
+                }
+                else
+                {
+                    head = m_Head.load(std::memory_order_relaxed);
+                }
+            }
+
+            slot->item = item;
+            slot->sequence.store(head + 1, std::memory_order_release);
+
+            return true;
+        }
+
+        bool Pop(T& item)
+        {
+            Slot& slot = m_Slots[m_Tail & s_Mask];
+
+            if (slot.sequence.load(std::memory_order_acquire) != m_Tail + 1)
+                return false;
+
+            item = slot.item;
+            slot.sequence.store(m_Tail + Capacity, std::memory_order_release);
+            ++m_Tail;
+
+            return true;
+        }
+    };
+}
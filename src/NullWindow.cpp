@@ -0,0 +1,656 @@
+#include <algorithm>
+
+#include "NullWindow.h"
+
+namespace awml {
+
+    NullWindow::NullWindow(
+        const std::wstring& title,
+        uint16_t width,
+        uint16_t height,
+        Context context,
+        WindowMode window_mode,
+        CursorMode cursor_mode,
+        bool resizable,
+        const FramebufferConfig& framebuffer,
+        const ContextConfig& context_config
+    ) : m_Title(title),
+        m_Width(width),
+        m_Height(height),
+        m_MouseX(0),
+        m_MouseY(0),
+        m_ContextType(context),
+        m_Context(nullptr),
+        m_ContextOwner(),
+        m_RenderThread(),
+        m_Framebuffer(framebuffer),
+        m_ContextConfig(context_config),
+        m_WindowMode(window_mode),
+        m_CursorMode(cursor_mode),
+        m_Launched(false),
+        m_ShouldClose(false),
+        m_FakeClock(true),
+        m_Time(0),
+        m_FrameCount(0),
+        m_Posted(),
+        m_WakeupPending(false),
+        m_KeysDown(),
+        m_Coalescer(m_Events),
+        m_FrameLimiter(),
+        m_QueueInterest(ALL_EVENTS)
+    {
+        // Nobody can drag the edges of a headless window.
+        (void)resizable;
+    }
+
+    bool NullWindow::EnsureAlive()
+    {
+        if (!m_Launched)
+        {
+            NotifyError(error::WINDOW, "Window has not yet been launched!");
+            return false;
+        }
+
+        return true;
+    }
+
+    uint64_t NullWindow::Now()
+    {
+        if (m_FakeClock)
+            return m_Time;
+
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                clock::now().time_since_epoch()
+            ).count()
+        );
+    }
+
+    bool NullWindow::InjectEvent(const Event& event)
+    {
+        if (m_Events.Space() <= EventCoalescer::s_MaxHeld)
+            return false;
+
+        Event injected = event;
+
+        if (!injected.timestamp)
+            injected.timestamp = Now();
+
+        if (!injected.count)
+            injected.count = 1;
+
+        Emit(injected);
+
+        return true;
+    }
+
+    void NullWindow::SetTime(uint64_t nanoseconds)
+    {
+        m_Time = nanoseconds;
+    }
+
+    void NullWindow::AdvanceTime(std::chrono::nanoseconds delta)
+    {
+        if (delta.count() > 0)
+            m_Time += static_cast<uint64_t>(delta.count());
+    }
+
+    uint64_t NullWindow::GetTime()
+    {
+        return Now();
+    }
+
+    uint64_t NullWindow::GetFrameCount()
+    {
+        return m_FrameCount.load(std::memory_order_relaxed);
+    }
+
+    bool NullWindow::Launch()
+    {
+        if (m_ContextType == Context::OpenGL && !m_Context)
+            m_Context = std::make_unique<NullContext>();
+
+        if (m_Context && (!m_Context->Setup(this) || !m_Context->Activate()))
+        {
+            NotifyError(error::CONTEXT, "Failed to set up the graphics context!");
+            return false;
+        }
+
+        if (m_Context)
+            m_ContextOwner.Acquire();
+
+        m_Launched = true;
+
+        return true;
+    }
+
+    bool NullWindow::EnableInputThread(const InputThreadConfig& config)
+    {
+        // Nothing is read from a system, so there
+        // is no work to move off the polling thread.
+        (void)config;
+        return true;
+    }
+
+    bool NullWindow::SetContext(window_context wc)
+    {
+        m_Context = std::move(wc);
+
+        return true;
+    }
+
+    bool NullWindow::BeginPoll()
+    {
+        return m_Launched;
+    }
+
+    bool NullWindow::BeginDispatch()
+    {
+        return EnsureAlive();
+    }
+
+    int NullWindow::GetEventFd()
+    {
+        return -1;
+    }
+
+    void NullWindow::Flush()
+    {
+    }
+
+    void NullWindow::WaitEvents()
+    {
+        if (!EnsureAlive())
+            return;
+
+        WaitUntil(nullptr);
+        PollEvents();
+    }
+
+    void NullWindow::WaitEventsTimeout(std::chrono::nanoseconds timeout)
+    {
+        if (!EnsureAlive())
+            return;
+
+        if (timeout.count() < 0)
+            timeout = std::chrono::nanoseconds::zero();
+
+        WaitUntil(&timeout);
+        PollEvents();
+    }
+
+    std::chrono::nanoseconds NullWindow::NextEventDelay()
+    {
+        return std::chrono::nanoseconds(-1);
+    }
+
+    void NullWindow::WaitUntil(const std::chrono::nanoseconds* timeout)
+    {
+        auto deadline = timeout ? clock::now() + *timeout : clock::time_point::max();
+        uint64_t fake_deadline = timeout ? m_Time + static_cast<uint64_t>(timeout->count()) : 0;
+
+        // Injected events may still be held back by the coalescer.
+        m_Coalescer.Flush();
+
+        std::unique_lock<std::mutex> lock(m_WakeupLock);
+
+        for (;;)
+        {
+            if (m_WakeupPending.exchange(false, std::memory_order_acquire))
+                return;
+
+            if (!m_Events.Empty())
+                return;
+
+            auto delay = NextEventDelay();
+
+            if (delay.count() == 0)
+                return;
+
+            // Nothing but posted events can arrive anymore.
+            if (delay.count() < 0 && ShouldClose())
+                return;
+
+            if (m_FakeClock)
+            {
+                // Skip ahead to whatever comes first instead of sleeping.
+                if (delay.count() > 0)
+                {
+                    uint64_t due = m_Time + static_cast<uint64_t>(delay.count());
+                    m_Time = timeout ? (std::min)(due, fake_deadline) : due;
+                    return;
+                }
+
+                if (timeout)
+                {
+                    m_Time = fake_deadline;
+                    return;
+                }
+
+                // Only another thread can end this wait.
+                m_WakeupSignal.wait(lock);
+                continue;
+            }
+
+            auto now = clock::now();
+
+            if (now >= deadline)
+                return;
+
+            if (delay.count() < 0 && !timeout)
+                m_WakeupSignal.wait(lock);
+            else if (delay.count() < 0)
+                m_WakeupSignal.wait_until(lock, deadline);
+            else
+                m_WakeupSignal.wait_until(lock, (std::min)(deadline, now + delay));
+        }
+    }
+
+    bool NullWindow::PumpEvents()
+    {
+        Event posted;
+
+        while (m_Events.Space() > EventCoalescer::s_MaxHeld && m_Posted.Pop(posted))
+        {
+            posted.timestamp = Now();
+            Emit(posted);
+        }
+
+        if (m_Events.Space() > EventCoalescer::s_MaxHeld)
+            QueueEvents();
+
+        m_Coalescer.Flush();
+
+        return NextEventDelay().count() == 0;
+    }
+
+    void NullWindow::ApplyWindowState(const Event& event)
+    {
+        switch (event.type)
+        {
+        case EventType::WINDOW_RESIZED:
+            m_Width = event.size.width;
+            m_Height = event.size.height;
+            break;
+        case EventType::MOUSE_MOVED:
+            m_MouseX = event.mouse.x;
+            m_MouseY = event.mouse.y;
+            break;
+        case EventType::KEY_PRESSED:
+            m_KeysDown.Set(event.key.key);
+            break;
+        case EventType::KEY_RELEASED:
+            m_KeysDown.Reset(event.key.key);
+            break;
+        case EventType::MOUSE_PRESSED:
+            m_KeysDown.Set(event.button.button);
+            break;
+        case EventType::MOUSE_RELEASED:
+            m_KeysDown.Reset(event.button.button);
+            break;
+        default:
+            break;
+        }
+    }
+
+    void NullWindow::Emit(const Event& event)
+    {
+        // Resizes always go through to keep the window size up to date.
+        event_mask wanted =
+            m_Callbacks.Mask() |
+            m_QueueInterest    |
+            m_Awaiters.Mask() |
+            (m_TrackInput ? InputTracker::Mask() : 0) |
+            EventBit(EventType::WINDOW_RESIZED);
+
+        if (wanted & EventBit(event.type))
+            m_Coalescer.Stage(event);
+    }
+
+    void NullWindow::SwapBuffers()
+    {
+        if (m_Context)
+            m_Context->SwapBuffers();
+
+        m_FrameCount.fetch_add(1, std::memory_order_relaxed);
+        m_Awaiters.EndFrame();
+    }
+
+    void NullWindow::Update()
+    {
+        if (!m_FakeClock)
+            m_FrameLimiter.Wait();
+        else if (m_FrameLimiter.Enabled())
+            m_Time += static_cast<uint64_t>(m_FrameLimiter.Period().count());
+
+        PollEvents();
+        SwapBuffers();
+    }
+
+    void NullWindow::SetTitle(const std::wstring& title)
+    {
+        m_Title = title;
+    }
+
+    void NullWindow::Close()
+    {
+        StopRenderThread();
+        m_ShouldClose.store(true, std::memory_order_relaxed);
+        StopRecording();
+    }
+
+    void NullWindow::OnKeyPressed(
+        key_pressed_callback cb
+    )
+    {
+        m_Callbacks.key_pressed = cb;
+    }
+
+    void NullWindow::OnKeyReleased(
+        key_released_callback cb
+    )
+    {
+        m_Callbacks.key_released = cb;
+    }
+
+    void NullWindow::OnWindowResized(
+        window_resized_callback cb
+    )
+    {
+        m_Callbacks.window_resized = cb;
+    }
+
+    void NullWindow::OnWindowClosed(
+        window_closed_callback cb
+    )
+    {
+        m_Callbacks.window_closed = cb;
+    }
+
+    void NullWindow::OnMouseMoved(
+        mouse_moved_callback cb
+    )
+    {
+        m_Callbacks.mouse_moved = cb;
+    }
+
+    void NullWindow::OnMousePressed(
+        mouse_pressed_callback cb
+    )
+    {
+        m_Callbacks.mouse_pressed = cb;
+    }
+
+    void NullWindow::OnMouseReleased(
+        mouse_released_callback cb
+    )
+    {
+        m_Callbacks.mouse_released = cb;
+    }
+
+    void NullWindow::OnMouseScrolled(
+        mouse_scrolled_callback cb
+    )
+    {
+        m_Callbacks.mouse_scrolled = cb;
+    }
+
+    void NullWindow::OnCharTyped(
+        char_typed_callback cb
+    )
+    {
+        m_Callbacks.char_typed = cb;
+    }
+
+    void NullWindow::OnUserEvent(
+        user_event_callback cb
+    )
+    {
+        m_Callbacks.user_event = cb;
+    }
+
+    void NullWindow::SetCallbackExecutor(
+        EventType type,
+        callback_executor executor
+    )
+    {
+        if (!m_Callbacks.SetExecutor(type, executor))
+            NotifyError(error::ARGS, "There is no callback for this event type!");
+    }
+
+    bool NullWindow::PostEvent(const UserEvent& user)
+    {
+        Event event;
+        event.type = EventType::USER;
+        event.count = 1;
+        // Stamped by the consumer, the fake clock isn't thread-safe.
+        event.timestamp = 0;
+        event.user = user;
+
+        if (!m_Posted.Push(event))
+            return false;
+
+        Wakeup();
+
+        return true;
+    }
+
+    void NullWindow::Wakeup()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_WakeupLock);
+            m_WakeupPending.store(true, std::memory_order_release);
+        }
+
+        m_WakeupSignal.notify_all();
+    }
+
+    void NullWindow::SetEventCoalescing(Coalesce mode)
+    {
+        m_Coalescer.SetMode(mode);
+    }
+
+    void NullWindow::SelectEvents(event_mask mask)
+    {
+        m_QueueInterest = mask;
+    }
+
+    bool NullWindow::StartRecording(const std::string& path)
+    {
+        if (!m_Recorder.Start(path, m_Width, m_Height))
+        {
+            NotifyError(error::GENERIC, "Failed to create the event log!");
+            return false;
+        }
+
+        return true;
+    }
+
+    void NullWindow::StopRecording()
+    {
+        m_Recorder.Stop();
+    }
+
+    bool NullWindow::IsKeyPressed(awml_key key_code)
+    {
+        if (key_code == awml_key::UNKNOWN || static_cast<size_t>(key_code) >= AWML_KEY_COUNT)
+            return false;
+
+        return m_KeysDown.Test(key_code);
+    }
+
+    const InputSnapshot& NullWindow::BeginFrame()
+    {
+        m_TrackInput = true;
+
+        return m_Input.Publish(m_KeysDown);
+    }
+
+    void NullWindow::SetCursorMode(CursorMode cursor_mode)
+    {
+        m_CursorMode = cursor_mode;
+    }
+
+    void NullWindow::SetWindowMode(WindowMode window_mode)
+    {
+        m_WindowMode = window_mode;
+    }
+
+    void NullWindow::Resize(uint16_t width, uint16_t height)
+    {
+        // Reported back like a window manager would.
+        Event event;
+        event.type = EventType::WINDOW_RESIZED;
+        event.count = 1;
+        event.timestamp = 0;
+        event.size = { width, height };
+
+        InjectEvent(event);
+    }
+
+    const FramebufferConfig& NullWindow::GetFramebufferConfig()
+    {
+        return m_Framebuffer;
+    }
+
+    const ContextConfig& NullWindow::GetContextConfig()
+    {
+        return m_ContextConfig;
+    }
+
+    void* NullWindow::GetNativeHandle()
+    {
+        return nullptr;
+    }
+
+    bool NullWindow::SetSwapInterval(int interval)
+    {
+        if (!m_Context)
+        {
+            NotifyError(error::CONTEXT, "The window has no graphics context!");
+            return false;
+        }
+
+        return m_Context->SetSwapInterval(interval);
+    }
+
+    SwapControl NullWindow::GetSwapControl()
+    {
+        return m_Context ? m_Context->GetSwapControl() : SwapControl::NONE;
+    }
+
+    bool NullWindow::SetMaxFramesInFlight(uint32_t frames)
+    {
+        if (!m_Context)
+        {
+            NotifyError(error::CONTEXT, "The window has no graphics context!");
+            return false;
+        }
+
+        return m_Context->SetMaxFramesInFlight(frames);
+    }
+
+    std::chrono::nanoseconds NullWindow::GetFrameWaitTime()
+    {
+        return m_Context ? m_Context->GetFrameWaitTime() : std::chrono::nanoseconds::zero();
+    }
+
+    void NullWindow::SetTargetFrameRate(double hz)
+    {
+        m_FrameLimiter.SetRate(hz);
+    }
+
+    FramePacingStats NullWindow::GetFramePacingStats()
+    {
+        return m_FrameLimiter.Stats();
+    }
+
+    void NullWindow::MakeCurrent()
+    {
+        if (!m_Context)
+            return;
+
+        if (!m_ContextOwner.Acquire())
+        {
+            NotifyError(
+                error::CONTEXT,
+                "The context is current on another thread, release it there first!"
+            );
+
+            return;
+        }
+
+        m_Context->MakeCurrent();
+    }
+
+    void NullWindow::ReleaseCurrent()
+    {
+        if (!m_Context || !m_ContextOwner.IsOwner())
+            return;
+
+        m_Context->ReleaseCurrent();
+        m_ContextOwner.Release();
+    }
+
+    bool NullWindow::StartRenderThread(render_callback render)
+    {
+        if (!EnsureAlive())
+            return false;
+
+        if (!m_Context)
+        {
+            NotifyError(error::CONTEXT, "A render thread needs a graphics context!");
+            return false;
+        }
+
+        if (m_RenderThread.Running())
+        {
+            NotifyError(error::GENERIC, "The render thread is already running!");
+            return false;
+        }
+
+        ReleaseCurrent();
+        if (!m_RenderThread.Start(*this, m_ContextOwner, render))
+        {
+            // Reported on the render thread if there was a callback.
+            if (!m_RenderThread.Error().empty())
+                NotifyError(error::CONTEXT, m_RenderThread.Error());
+
+            return false;
+        }
+
+        return true;
+    }
+
+    void NullWindow::StopRenderThread()
+    {
+        m_RenderThread.Stop();
+    }
+
+    void NullWindow::Suspend(AwaitNode& node)
+    {
+        m_Awaiters.Push(node);
+    }
+
+    void* NullWindow::AllocateCoroutine(size_t size)
+    {
+        return m_Awaiters.Arena().Allocate(size);
+    }
+
+    void NullWindow::FreeCoroutine(void* frame, size_t size)
+    {
+        m_Awaiters.Arena().Free(frame, size);
+    }
+
+    NullWindow::~NullWindow()
+    {
+        StopRenderThread();
+        StopRecording();
+        m_Awaiters.DestroySuspended();
+    }
+
+    HeadlessControl* GetHeadlessControl(Window& window)
+    {
+        return dynamic_cast<HeadlessControl*>(&window);
+    }
+}
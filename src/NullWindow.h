@@ -0,0 +1,301 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+#include <AWML/awml.h>
+#include <AWML/headless.h>
+
+#include "EventCoalescer.h"
+#include "EventWindow.h"
+#include "MPSCQueue.h"
+#include "FrameLimiter.h"
+#include "RenderThread.h"
+#include "utilities.h"
+
+namespace awml {
+
+    // A GraphicsContext that does nothing, used by the
+    // headless windows when a context is requested.
+    class NullContext : public GraphicsContext
+    {
+    public:
+        bool Setup(Window*) override { return true; }
+        bool Activate() override { return true; }
+        void SwapBuffers() override {}
+        void MakeCurrent() override {}
+        void ReleaseCurrent() override {}
+
+        // Accepted and ignored, there is no display to sync to.
+        bool SetSwapInterval(int) override { return true; }
+        SwapControl GetSwapControl() override { return SwapControl::INTERVAL | SwapControl::ADAPTIVE; }
+
+        // There is no GPU to wait for.
+        bool SetMaxFramesInFlight(uint32_t) override { return true; }
+        std::chrono::nanoseconds GetFrameWaitTime() override { return std::chrono::nanoseconds::zero(); }
+    };
+
+    // A window without a window system, so the event and frame loop
+    // machinery can be benchmarked and tested in isolation. Driven
+    // through its HeadlessControl, see GetHeadlessControl.
+    class NullWindow : public EventWindow, public HeadlessControl
+    {
+    protected:
+        typedef std::chrono::steady_clock clock;
+
+        std::wstring m_Title;
+
+        uint16_t m_Width;
+        uint16_t m_Height;
+
+        uint16_t m_MouseX;
+        uint16_t m_MouseY;
+
+        Context        m_ContextType;
+        window_context m_Context;
+        ContextOwner   m_ContextOwner;
+        RenderThread   m_RenderThread;
+
+        // Nothing is chosen, reported as requested.
+        FramebufferConfig m_Framebuffer;
+
+        // Reported as requested.
+        ContextConfig m_ContextConfig;
+
+        WindowMode m_WindowMode;
+        CursorMode m_CursorMode;
+
+        bool m_Launched;
+
+        std::atomic<bool> m_ShouldClose;
+
+        // Nanoseconds on the fake clock, unused with the real one.
+        bool     m_FakeClock;
+        uint64_t m_Time;
+
+        std::atomic<uint64_t> m_FrameCount;
+
+        MPSCQueue<Event, AWML_USER_EVENT_QUEUE_SIZE> m_Posted;
+        std::atomic<bool>       m_WakeupPending;
+        std::mutex              m_WakeupLock;
+        std::condition_variable m_WakeupSignal;
+
+        // Key and mouse button state rebuilt from the consumed events.
+        KeySet m_KeysDown;
+
+        EventCoalescer m_Coalescer;
+
+        // Skipped on the fake clock, which Update advances instead.
+        FrameLimiter m_FrameLimiter;
+
+        event_mask m_QueueInterest;
+    public:
+        NullWindow(
+            const std::wstring& title,
+            uint16_t width,
+            uint16_t height,
+            Context context,
+            WindowMode window_mode,
+            CursorMode cursor_mode,
+            bool resizable,
+            const FramebufferConfig& framebuffer = FramebufferConfig(),
+            const ContextConfig& context_config = ContextConfig()
+        );
+
+        bool InjectEvent(const Event& event) override;
+
+        void SetTime(uint64_t nanoseconds) override;
+        void AdvanceTime(std::chrono::nanoseconds delta) override;
+
+        uint64_t GetTime() override;
+
+        uint64_t GetFrameCount() override;
+
+        bool Launch() override;
+
+        bool EnableInputThread(const InputThreadConfig& config) override;
+
+        bool SetContext(window_context wc) override;
+
+        int GetEventFd() override;
+
+        void Flush() override;
+
+        void WaitEvents() override;
+        void WaitEventsTimeout(std::chrono::nanoseconds timeout) override;
+        void SwapBuffers() override;
+
+        void Update() override;
+
+        bool SetSwapInterval(int interval) override;
+        SwapControl GetSwapControl() override;
+
+        void SetTargetFrameRate(double hz) override;
+        FramePacingStats GetFramePacingStats() override;
+
+        bool SetMaxFramesInFlight(uint32_t frames) override;
+        std::chrono::nanoseconds GetFrameWaitTime() override;
+
+        void SetTitle(const std::wstring& title) override;
+
+        bool ShouldClose() override;
+
+        void Close() override;
+
+        uint16_t GetWidth() override;
+        uint16_t GetHeight() override;
+
+        uint16_t GetMouseX() override;
+        uint16_t GetMouseY() override;
+        std::pair<uint16_t, uint16_t> GetMouseCoords() override;
+
+        void OnKeyPressed(
+            key_pressed_callback cb
+        ) override;
+
+        void OnKeyReleased(
+            key_released_callback cb
+        ) override;
+
+        void OnWindowResized(
+            window_resized_callback cb
+        ) override;
+
+        void OnWindowClosed(
+            window_closed_callback cb
+        ) override;
+
+        void OnMouseMoved(
+            mouse_moved_callback cb
+        ) override;
+
+        void OnMousePressed(
+            mouse_pressed_callback cb
+        ) override;
+
+        void OnMouseReleased(
+            mouse_released_callback cb
+        ) override;
+
+        void OnMouseScrolled(
+            mouse_scrolled_callback cb
+        ) override;
+
+        void OnCharTyped(
+            char_typed_callback cb
+        ) override;
+
+        void OnUserEvent(
+            user_event_callback cb
+        ) override;
+
+        void SetCallbackExecutor(
+            EventType type,
+            callback_executor executor
+        ) override;
+
+        bool PostEvent(const UserEvent& event) override;
+
+        void Wakeup() override;
+
+        void SetEventCoalescing(Coalesce mode) override;
+
+        void SelectEvents(event_mask mask) override;
+
+        bool StartRecording(const std::string& path) override;
+
+        void StopRecording() override;
+
+        bool Minimized() override;
+
+        bool IsKeyPressed(awml_key key_code) override;
+
+        const InputSnapshot& BeginFrame() override;
+
+        void SetCursorMode(CursorMode cursor_mode) override;
+
+        void SetWindowMode(WindowMode window_mode) override;
+
+        void Resize(uint16_t width, uint16_t height) override;
+
+        void* GetNativeHandle() override;
+
+        const FramebufferConfig& GetFramebufferConfig() override;
+
+        const ContextConfig& GetContextConfig() override;
+
+        void MakeCurrent() override;
+
+        void ReleaseCurrent() override;
+
+        bool StartRenderThread(render_callback render) override;
+
+        void StopRenderThread() override;
+
+        void Suspend(AwaitNode& node) override;
+
+        void* AllocateCoroutine(size_t size) override;
+        void FreeCoroutine(void* frame, size_t size) override;
+
+        virtual ~NullWindow();
+    protected:
+        bool EnsureAlive();
+
+        // The fake clock, or the steady clock if m_FakeClock is off.
+        uint64_t Now();
+
+        // Stages events from a source other than injection,
+        // called by every poll while there is room in the queue.
+        virtual void QueueEvents() {}
+
+        // Time until the next scheduled event is due, zero if it
+        // already is and negative if nothing is scheduled.
+        virtual std::chrono::nanoseconds NextEventDelay();
+
+        void Emit(const Event& event);
+    private:
+        void WaitUntil(const std::chrono::nanoseconds* timeout);
+
+        bool BeginPoll() override;
+        bool BeginDispatch() override;
+        bool PumpEvents() override;
+        void ApplyWindowState(const Event& event) override;
+    };
+
+    inline bool NullWindow::ShouldClose()
+    {
+        return m_ShouldClose.load(std::memory_order_relaxed);
+    }
+
+    inline uint16_t NullWindow::GetWidth()
+    {
+        return m_Width;
+    }
+
+    inline uint16_t NullWindow::GetHeight()
+    {
+        return m_Height;
+    }
+
+    inline uint16_t NullWindow::GetMouseX()
+    {
+        return m_MouseX;
+    }
+
+    inline uint16_t NullWindow::GetMouseY()
+    {
+        return m_MouseY;
+    }
+
+    inline std::pair<uint16_t, uint16_t> NullWindow::GetMouseCoords()
+    {
+        return { m_MouseX, m_MouseY };
+    }
+
+    inline bool NullWindow::Minimized()
+    {
+        return m_Width == 0 && m_Height == 0;
+    }
+}
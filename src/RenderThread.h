@@ -0,0 +1,146 @@
+#pragma once
+
+#include <atomic>
+#include <exception>
+#include <future>
+#include <string>
+#include <thread>
+
+#include <AWML/awml.h>
+
+namespace awml {
+
+    // Tracks which thread a window's graphics context is current on,
+    // a context can only be current on one thread at a time.
+    class ContextOwner
+    {
+    private:
+        std::atomic<std::thread::id> m_Owner;
+    public:
+        ContextOwner()
+            : m_Owner(std::thread::id())
+        {
+        }
+
+        // Claims the context for the calling thread,
+        // false if another thread still has it.
+        bool Acquire()
+        {
+            auto expected = std::thread::id();
+            auto self = std::this_thread::get_id();
+
+            return m_Owner.compare_exchange_strong(expected, self, std::memory_order_acq_rel) ||
+                   expected == self;
+        }
+
+        bool IsOwner() const
+        {
+            return m_Owner.load(std::memory_order_acquire) == std::this_thread::get_id();
+        }
+
+        void Release()
+        {
+            m_Owner.store(std::thread::id(), std::memory_order_release);
+        }
+    };
+
+    // Calls a render callback followed by SwapBuffers in a loop on
+    // a thread of its own, with the window's context current there.
+    // Stops when asked to or once the window should close.
+    class RenderThread
+    {
+    private:
+        std::thread       m_Thread;
+        std::atomic<bool> m_Running;
+
+        // Why the last Start failed, empty if the
+        // window's error callback was told already.
+        std::string m_Error;
+    public:
+        RenderThread()
+            : m_Running(false),
+            m_Error()
+        {
+        }
+
+        RenderThread(const RenderThread& other) = delete;
+        RenderThread& operator=(const RenderThread& other) = delete;
+
+        bool Running() const
+        {
+            return m_Thread.joinable();
+        }
+
+        const std::string& Error() const { return m_Error; }
+
+        // Returns once the thread has made the context current,
+        // false if it couldn't and is gone again.
+        bool Start(Window& window, ContextOwner& owner, render_callback render)
+        {
+            m_Running.store(true, std::memory_order_release);
+            m_Error.clear();
+
+            std::promise<bool> acquired;
+            auto result = acquired.get_future();
+
+            m_Thread = std::thread(
+                [this, &window, &owner, &acquired, render]()
+                {
+                    // MakeCurrent throws without an error callback,
+                    // nothing may escape the thread.
+                    try
+                    {
+                        window.MakeCurrent();
+                    }
+                    catch (const std::exception& e)
+                    {
+                        m_Error = e.what();
+                    }
+
+                    if (!owner.IsOwner())
+                    {
+                        acquired.set_value(false);
+                        return;
+                    }
+
+                    acquired.set_value(true);
+
+                    while (m_Running.load(std::memory_order_acquire) && !window.ShouldClose())
+                    {
+                        render();
+                        window.SwapBuffers();
+                    }
+
+                    // Hands the context back for MakeCurrent elsewhere.
+                    window.ReleaseCurrent();
+                }
+            );
+
+            if (result.get())
+                return true;
+
+            m_Thread.join();
+            m_Running.store(false, std::memory_order_release);
+
+            return false;
+        }
+
+        void Stop()
+        {
+            if (!m_Thread.joinable())
+                return;
+
+            m_Running.store(false, std::memory_order_release);
+
+            if (m_Thread.get_id() != std::this_thread::get_id())
+                m_Thread.join();
+            else
+                m_Thread.detach();
+        }
+
+        ~RenderThread()
+        {
+            Stop();
+        }
+    };
+}
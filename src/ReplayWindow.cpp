@@ -0,0 +1,78 @@
+#include "ReplayWindow.h"
+
+namespace awml {
+
+    ReplayWindow::ReplayWindow(const std::string& path, ReplaySpeed speed)
+        : NullWindow(
+            std::wstring(),
+            0, 0,
+            Context::NONE,
+            WindowMode::WINDOWED,
+            CursorMode::VISIBLE | CursorMode::FREE,
+            false
+        ),
+        m_Path(path),
+        m_Speed(speed),
+        m_Next(0),
+        m_LogStart(0),
+        m_ReplayStart(0)
+    {
+        // Real time playback follows the wall clock.
+        m_FakeClock = false;
+    }
+
+    bool ReplayWindow::Launch()
+    {
+        std::string failure = m_Log.Open(m_Path);
+
+        if (!failure.empty())
+        {
+            NotifyError(error::WINDOW, failure);
+            return false;
+        }
+
+        m_Width  = m_Log.Header().width;
+        m_Height = m_Log.Header().height;
+
+        m_Next = 0;
+        m_LogStart = m_Log.Count() ? m_Log.Events()[0].timestamp : 0;
+        m_ReplayStart = Now();
+
+        return NullWindow::Launch();
+    }
+
+    std::chrono::nanoseconds ReplayWindow::NextEventDelay()
+    {
+        if (!m_Launched || m_Next >= m_Log.Count())
+            return std::chrono::nanoseconds(-1);
+
+        if (m_Speed == ReplaySpeed::AS_FAST_AS_POSSIBLE)
+            return std::chrono::nanoseconds::zero();
+
+        uint64_t due = m_Log.Events()[m_Next].timestamp - m_LogStart + m_ReplayStart;
+        uint64_t now = Now();
+
+        return std::chrono::nanoseconds(due > now ? due - now : 0);
+    }
+
+    void ReplayWindow::QueueEvents()
+    {
+        // Recorded events are shifted to the replay's timeline.
+        while (m_Events.Space() > EventCoalescer::s_MaxHeld &&
+               NextEventDelay().count() == 0)
+        {
+            Event event = m_Log.Events()[m_Next++];
+
+            // Logs of older builds may have them, see EventRecorder.
+            if (event.type == EventType::USER)
+                continue;
+
+            event.timestamp = event.timestamp - m_LogStart + m_ReplayStart;
+            Emit(event);
+        }
+
+        // The poll that queued the last events also dispatches them.
+        if (m_Next >= m_Log.Count())
+            m_ShouldClose.store(true, std::memory_order_relaxed);
+    }
+}
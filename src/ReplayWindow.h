@@ -0,0 +1,34 @@
+#pragma once
+
+#include "NullWindow.h"
+#include "EventLog.h"
+
+namespace awml {
+
+    // A headless window that plays back an event log recorded with
+    // Window::StartRecording, so input handling can be benchmarked
+    // and regression tested deterministically without a display.
+    // The window reports ShouldClose once the whole log was dispatched.
+    class ReplayWindow final : public NullWindow
+    {
+    private:
+        std::string m_Path;
+        ReplaySpeed m_Speed;
+
+        EventLogReader m_Log;
+        uint64_t       m_Next;
+
+        // Recorded time of the first event and the time the
+        // replay started, the events are shifted by the difference.
+        uint64_t m_LogStart;
+        uint64_t m_ReplayStart;
+    public:
+        ReplayWindow(const std::string& path, ReplaySpeed speed);
+
+        bool Launch() override;
+    private:
+        void QueueEvents() override;
+
+        std::chrono::nanoseconds NextEventDelay() override;
+    };
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+namespace awml {
+
+    // A fixed capacity single-producer/single-consumer ring.
+    // Push is only ever called from one thread and Pop from
+    // one (possibly different) thread, no locks are taken.
+    template<typename T, size_t Capacity>
+    class RingBuffer
+    {
+    private:
+        static_assert(
+            Capacity && !(Capacity & (Capacity - 1)),
+            "RingBuffer capacity has to be a power of two"
+        );
+
+        static_assert(
+            std::is_trivially_copyable<T>::value,
+            "RingBuffer can only hold trivially copyable types"
+        );
+
+        static constexpr size_t s_Mask = Capacity - 1;
+
+        // Keep the indices on separate cache lines so
+        // the producer and the consumer don't fight over them.
+        alignas(64) std::atomic<size_t> m_Head;
+        alignas(64) std::atomic<size_t> m_Tail;
+
+        alignas(64) T m_Items[Capacity];
+    public:
+        RingBuffer()
+            : m_Head(0),
+            m_Tail(0)
+        {
+        }
+
+        RingBuffer(const RingBuffer& other) = delete;
+        RingBuffer& operator=(const RingBuffer& other) = delete;
+
+        bool Push(const T& item)
+        {
+            size_t head = m_Head.load(std::memory_order_relaxed);
+
+            if (head - m_Tail.load(std::memory_order_acquire) == Capacity)
+                return false;
+
+            m_Items[head & s_Mask] = item;
+            m_Head.store(head + 1, std::memory_order_release);
+
+            return true;
+        }
+
+        bool Pop(T& item)
+        {
+            return Pop(&item, 1);
+        }
+
+        size_t Pop(T* out, size_t max)
+        {
+            size_t tail = m_Tail.load(std::memory_order_relaxed);
+            size_t available = m_Head.load(std::memory_order_acquire) - tail;
+
+            if (available > max)
+                available = max;
+
+            for (size_t i = 0; i < available; ++i)
+                out[i] = m_Items[(tail + i) & s_Mask];
+
+            m_Tail.store(tail + available, std::memory_order_release);
+
+            return available;
+        }
+
+        // Consumer side access to the i-th queued item, it
+        // stays in place until it's popped or discarded.
+        T& At(size_t index)
+        {
+            return m_Items[(m_Tail.load(std::memory_order_relaxed) + index) & s_Mask];
+        }
+
+        // Drops the first count queued items.
+        void Discard(size_t count)
+        {
+            m_Tail.store(m_Tail.load(std::memory_order_relaxed) + count, std::memory_order_release);
+        }
+
+        size_t Size() const
+        {
+            return m_Head.load(std::memory_order_acquire) -
+                   m_Tail.load(std::memory_order_acquire);
+        }
+
+        size_t Space() const
+        {
+            return Capacity - Size();
+        }
+
+        bool Empty() const
+        {
+            return !Size();
+        }
+
+        static constexpr size_t GetCapacity()
+        {
+            return Capacity;
+        }
+    };
+}
@@ -0,0 +1,211 @@
+#include <algorithm>
+
+#include "WindowsEventLoop.h"
+#include "utilities.h"
+
+namespace awml {
+
+    WindowsEventLoop::WindowsEventLoop()
+        : m_WakeEvent(CreateEventW(NULL, FALSE, FALSE, NULL)),
+        m_NextTimer(1),
+        m_Stopped(false)
+    {
+    }
+
+    void WindowsEventLoop::OnError(error_callback cb)
+    {
+        m_ErrorCB = cb;
+    }
+
+    void WindowsEventLoop::NotifyError(error code, const std::string& message)
+    {
+        ReportError(m_ErrorCB, code, message);
+    }
+
+    bool WindowsEventLoop::AddWindow(Window& window)
+    {
+        if (std::find(m_Windows.begin(), m_Windows.end(), &window) == m_Windows.end())
+            m_Windows.push_back(&window);
+
+        return true;
+    }
+
+    void WindowsEventLoop::RemoveWindow(Window& window)
+    {
+        auto it = std::find(m_Windows.begin(), m_Windows.end(), &window);
+
+        if (it != m_Windows.end())
+            m_Windows.erase(it);
+    }
+
+    timer_id WindowsEventLoop::AddTimer(
+        std::chrono::nanoseconds delay,
+        timer_callback cb,
+        std::chrono::nanoseconds interval
+    )
+    {
+        Timer timer;
+        timer.id = m_NextTimer++;
+        timer.deadline = clock::now() + (std::max)(delay, std::chrono::nanoseconds::zero());
+        timer.interval = (std::max)(interval, std::chrono::nanoseconds::zero());
+        timer.on_timer = std::move(cb);
+
+        m_Timers.push_back(std::move(timer));
+
+        return m_Timers.back().id;
+    }
+
+    void WindowsEventLoop::CancelTimer(timer_id id)
+    {
+        m_Timers.erase(
+            std::remove_if(
+                m_Timers.begin(),
+                m_Timers.end(),
+                [id](const Timer& timer) { return timer.id == id; }
+            ),
+            m_Timers.end()
+        );
+    }
+
+    bool WindowsEventLoop::WatchFd(int fd, FdEvent events, fd_callback cb)
+    {
+        NotifyError(error::GENERIC, "Watching fds is not supported on Windows!");
+        return false;
+    }
+
+    void WindowsEventLoop::UnwatchFd(int fd)
+    {
+    }
+
+    void WindowsEventLoop::Run()
+    {
+        while (RunOnce(std::chrono::nanoseconds(-1)))
+            ;
+
+        // Allows running the loop again later.
+        m_Stopped.store(false, std::memory_order_relaxed);
+    }
+
+    bool WindowsEventLoop::RunOnce(std::chrono::nanoseconds timeout)
+    {
+        if (!m_WakeEvent)
+        {
+            NotifyError(error::GENERIC, "Failed to create the event loop!");
+            return false;
+        }
+
+        DispatchWindows();
+
+        if (m_Stopped.load(std::memory_order_relaxed) || WindowsClosed())
+            return false;
+
+        auto now = clock::now();
+
+        DWORD wait = INFINITE;
+
+        // Round up so sub-millisecond waits still sleep.
+        if (timeout.count() >= 0)
+            wait = static_cast<DWORD>(
+                (std::min)((timeout.count() + 999999) / 1000000, static_cast<int64_t>(INFINITE - 1))
+            );
+
+        for (const auto& timer : m_Timers)
+        {
+            auto due = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                timer.deadline - now
+            ).count();
+
+            DWORD due_ms = due <= 0 ? 0 : static_cast<DWORD>(
+                (std::min)((due + 999999) / 1000000, static_cast<int64_t>(INFINITE - 1))
+            );
+
+            wait = (std::min)(wait, due_ms);
+        }
+
+        MsgWaitForMultipleObjectsEx(
+            1, &m_WakeEvent,
+            wait,
+            QS_ALLINPUT,
+            MWMO_INPUTAVAILABLE
+        );
+
+        DispatchWindows();
+        DispatchTimers();
+
+        return !m_Stopped.load(std::memory_order_relaxed) && !WindowsClosed();
+    }
+
+    void WindowsEventLoop::Stop()
+    {
+        m_Stopped.store(true, std::memory_order_relaxed);
+        SetEvent(m_WakeEvent);
+    }
+
+    void WindowsEventLoop::DispatchWindows()
+    {
+        for (auto window : m_Windows)
+            window->DispatchPending();
+    }
+
+    void WindowsEventLoop::DispatchTimers()
+    {
+        auto now = clock::now();
+
+        // Collected first, the callbacks may add or cancel timers.
+        std::vector<timer_id> due;
+
+        for (const auto& timer : m_Timers)
+        {
+            if (timer.deadline <= now)
+                due.push_back(timer.id);
+        }
+
+        for (auto id : due)
+        {
+            auto it = std::find_if(
+                m_Timers.begin(),
+                m_Timers.end(),
+                [id](const Timer& timer) { return timer.id == id; }
+            );
+
+            if (it == m_Timers.end())
+                continue;
+
+            timer_callback cb = it->on_timer;
+
+            if (it->interval.count() > 0)
+            {
+                // Skip the periods that were missed entirely.
+                do
+                    it->deadline += it->interval;
+                while (it->deadline <= now);
+            }
+            else
+            {
+                m_Timers.erase(it);
+            }
+
+            cb();
+        }
+    }
+
+    bool WindowsEventLoop::WindowsClosed()
+    {
+        if (m_Windows.empty())
+            return false;
+
+        for (auto window : m_Windows)
+        {
+            if (!window->ShouldClose())
+                return false;
+        }
+
+        return true;
+    }
+
+    WindowsEventLoop::~WindowsEventLoop()
+    {
+        if (m_WakeEvent)
+            CloseHandle(m_WakeEvent);
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <windows.h>
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+#include <AWML/event_loop.h>
+
+namespace awml {
+
+    // The EventLoop for Windows, sleeps in MsgWaitForMultipleObjectsEx
+    // until a message arrives, the next timer is due or Stop is called.
+    // Arbitrary fds can't be waited on alongside the message queue,
+    // so WatchFd is not supported.
+    class WindowsEventLoop : public EventLoop
+    {
+    private:
+        typedef std::chrono::steady_clock clock;
+
+        struct Timer
+        {
+            timer_id                 id;
+            clock::time_point        deadline;
+            std::chrono::nanoseconds interval;
+            timer_callback           on_timer;
+        };
+
+        HANDLE m_WakeEvent;
+
+        std::vector<Timer>   m_Timers;
+        std::vector<Window*> m_Windows;
+
+        timer_id m_NextTimer;
+
+        std::atomic<bool> m_Stopped;
+
+        error_callback m_ErrorCB;
+    public:
+        WindowsEventLoop();
+
+        void OnError(error_callback cb) override;
+
+        bool AddWindow(Window& window) override;
+
+        void RemoveWindow(Window& window) override;
+
+        timer_id AddTimer(
+            std::chrono::nanoseconds delay,
+            timer_callback cb,
+            std::chrono::nanoseconds interval
+        ) override;
+
+        void CancelTimer(timer_id id) override;
+
+        bool WatchFd(int fd, FdEvent events, fd_callback cb) override;
+
+        void UnwatchFd(int fd) override;
+
+        void Run() override;
+
+        bool RunOnce(std::chrono::nanoseconds timeout) override;
+
+        void Stop() override;
+
+        ~WindowsEventLoop();
+    private:
+        void NotifyError(error code, const std::string& message);
+
+        void DispatchWindows();
+        void DispatchTimers();
+
+        bool WindowsClosed();
+    };
+}
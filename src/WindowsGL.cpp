@@ -4,6 +4,8 @@
 #include "WindowsGL.h"
 
 PFNWGLCREATECONTEXTATTRIBSARBPROC wglCreateContextAttribsARB;
+PFNWGLSWAPINTERVALEXTPROC         wglSwapIntervalEXT;
+PFNWGLGETEXTENSIONSSTRINGEXTPROC  wglGetExtensionsStringEXT;
 
 // 1.0
 PFNGLCULLFACEPROC                                    awml_glCullFace;
@@ -708,6 +710,10 @@ namespace awml {
         wglCreateContextAttribsARB = (PFNWGLCREATECONTEXTATTRIBSARBPROC)wglGetProcAddress("wglCreateContextAttribsARB");
         awml_glGetString = (PFNGLGETSTRINGPROC)try_load("glGetString");
 
+        // Optional, null without WGL_EXT_swap_control.
+        wglSwapIntervalEXT = (PFNWGLSWAPINTERVALEXTPROC)wglGetProcAddress("wglSwapIntervalEXT");
+        wglGetExtensionsStringEXT = (PFNWGLGETEXTENSIONSSTRINGEXTPROC)wglGetProcAddress("wglGetExtensionsStringEXT");
+
         if (wglCreateContextAttribsARB && awml_glGetString)
             return true;
 
@@ -3,7 +3,9 @@
 #include <functional>
 
 #include "WindowsGL.h"
+#include "GLContextInfo.h"
 #include "WindowsWindow.h"
+#include "KeyTables.h"
 
 #include "utilities.h"
 
@@ -13,7 +15,9 @@ namespace awml {
         : m_Context(),
         m_OpenGLContext(),
         m_Format(),
-        m_Parent()
+        m_Parent(),
+        m_SwapControl(SwapControl::NONE),
+        m_Fences()
     {
     }
 
@@ -26,32 +30,47 @@ namespace awml {
     {
         m_Parent = static_cast<WindowsWindow*>(self);
 
-        PIXELFORMATDESCRIPTOR pfd =
-        {
-            sizeof(PIXELFORMATDESCRIPTOR),
-            1,
-            PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL | PFD_DOUBLEBUFFER,
-            PFD_TYPE_RGBA,
-            32,
-            0, 0, 0, 0, 0, 0,
-            0,
-            0,
-            0,
-            0, 0, 0, 0,
-            24,
-            8,
-            0,
-            PFD_MAIN_PLANE,
-            0,
-            0, 0, 0
-        };
+        const FramebufferConfig& requested = m_Parent->m_Framebuffer;
+
+        PIXELFORMATDESCRIPTOR pfd = { sizeof(PIXELFORMATDESCRIPTOR), 1 };
+        pfd.dwFlags      = PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL;
+        pfd.iPixelType   = PFD_TYPE_RGBA;
+        pfd.cColorBits   = requested.red_bits + requested.green_bits + requested.blue_bits;
+        pfd.cAlphaBits   = requested.alpha_bits;
+        pfd.cDepthBits   = requested.depth_bits;
+        pfd.cStencilBits = requested.stencil_bits;
+        pfd.iLayerType   = PFD_MAIN_PLANE;
+
+        if (requested.double_buffered)
+            pfd.dwFlags |= PFD_DOUBLEBUFFER;
 
         m_Context = GetDC(m_Parent->m_Window);
 
         m_Format = ChoosePixelFormat(m_Context, &pfd);
 
+        if (!m_Format || !DescribePixelFormat(m_Context, m_Format, sizeof(pfd), &pfd))
+        {
+            m_Parent->NotifyError(error::CONTEXT, "No framebuffer config matches the request!");
+            return false;
+        }
+
         SetPixelFormat(m_Context, m_Format, &pfd);
 
+        // The legacy pixel formats have no multisampling or sRGB,
+        // reported as such.
+        FramebufferConfig chosen;
+        chosen.red_bits        = pfd.cRedBits;
+        chosen.green_bits      = pfd.cGreenBits;
+        chosen.blue_bits       = pfd.cBlueBits;
+        chosen.alpha_bits      = pfd.cAlphaBits;
+        chosen.depth_bits      = pfd.cDepthBits;
+        chosen.stencil_bits    = pfd.cStencilBits;
+        chosen.samples         = 0;
+        chosen.srgb            = false;
+        chosen.double_buffered = (pfd.dwFlags & PFD_DOUBLEBUFFER) != 0;
+
+        m_Parent->m_Framebuffer = chosen;
+
         m_OpenGLContext = wglCreateContext(m_Context);
 
         if (!m_OpenGLContext)
@@ -68,17 +87,13 @@ namespace awml {
         if (!EnsureSetup())
             return false;
 
-        int attriblist[] = 
+        const ContextConfig& requested = m_Parent->m_ContextConfig;
+
+        if (requested.no_error && (requested.debug || requested.robust))
         {
-            WGL_CONTEXT_MAJOR_VERSION_ARB,
-            0,
-            WGL_CONTEXT_MINOR_VERSION_ARB,
-            0,
-            WGL_CONTEXT_PROFILE_MASK_ARB,
-            WGL_CONTEXT_CORE_PROFILE_BIT_ARB,
-            0,
-            0
-        };
+            m_Parent->NotifyError(error::ARGS, "A no-error context can't be a debug or robust context!");
+            return false;
+        }
 
         wglMakeCurrent(m_Context, m_OpenGLContext);
         if (!glLoader::Init())
@@ -87,18 +102,17 @@ namespace awml {
             return false;
         }
 
-        auto glversion = glGetString(GL_VERSION);
+        int major;
+        int minor;
+        ParseGLVersion(glGetString(GL_VERSION), major, minor);
 
-        if (!glversion)
+        if (!major)
         {
             m_Parent->NotifyError(error::CONTEXT, "Failed to detect OpenGL version!");
             return false;
         }
 
-        attriblist[1] = glversion[0] - '0';
-        attriblist[3] = glversion[2] - '0';
-
-        if (!glLoader::LoadVersion(attriblist[1], attriblist[3]))
+        if (!glLoader::LoadVersion(major, minor))
         {
             m_Parent->NotifyError(error::CONTEXT, "Failed to load OpenGL functions!");
             return false;
@@ -107,7 +121,66 @@ namespace awml {
         wglMakeCurrent(m_Context, NULL);
         wglDeleteContext(m_OpenGLContext);
 
+        // Without a requested version the one of the legacy context is used.
+        int attriblist[16];
+        int count = 0;
+
+        auto attrib = [&attriblist, &count](int name, int value)
+        {
+            attriblist[count++] = name;
+            attriblist[count++] = value;
+        };
+
+        attrib(WGL_CONTEXT_MAJOR_VERSION_ARB, requested.major ? requested.major : major);
+        attrib(WGL_CONTEXT_MINOR_VERSION_ARB, requested.major ? requested.minor : minor);
+
+        if (requested.profile != GLProfile::DEFAULT)
+        {
+            attrib(
+                WGL_CONTEXT_PROFILE_MASK_ARB,
+                requested.profile == GLProfile::CORE ?
+                    WGL_CONTEXT_CORE_PROFILE_BIT_ARB :
+                    WGL_CONTEXT_COMPATIBILITY_PROFILE_BIT_ARB
+            );
+        }
+
+        int flags =
+            (requested.debug              ? WGL_CONTEXT_DEBUG_BIT_ARB              : 0) |
+            (requested.forward_compatible ? WGL_CONTEXT_FORWARD_COMPATIBLE_BIT_ARB : 0);
+
+        int required = count;
+
+        // Drivers without the robustness or no-error extension reject
+        // these, the context is created again without them then.
+        if (requested.robust)
+        {
+            flags |= WGL_CONTEXT_ROBUST_ACCESS_BIT_ARB;
+            attrib(WGL_CONTEXT_RESET_NOTIFICATION_STRATEGY_ARB, WGL_LOSE_CONTEXT_ON_RESET_ARB);
+        }
+
+        if (requested.no_error)
+            attrib(WGL_CONTEXT_OPENGL_NO_ERROR_ARB, TRUE);
+
+        if (flags)
+            attrib(WGL_CONTEXT_FLAGS_ARB, flags);
+
+        attriblist[count] = 0;
+
         m_OpenGLContext = wglCreateContextAttribsARB(m_Context, 0, attriblist);
+
+        if (!m_OpenGLContext && count > required)
+        {
+            flags &= ~WGL_CONTEXT_ROBUST_ACCESS_BIT_ARB;
+            count = required;
+
+            if (flags)
+                attrib(WGL_CONTEXT_FLAGS_ARB, flags);
+
+            attriblist[count] = 0;
+
+            m_OpenGLContext = wglCreateContextAttribsARB(m_Context, 0, attriblist);
+        }
+
         if (!m_OpenGLContext)
         {
             m_Parent->NotifyError(error::CONTEXT, "Failed to create an OpenGL context!");
@@ -116,6 +189,15 @@ namespace awml {
 
         wglMakeCurrent(m_Context, m_OpenGLContext);
 
+        m_Parent->m_ContextConfig = QueryContextConfig();
+
+        if (wglSwapIntervalEXT)
+            m_SwapControl = SwapControl::INTERVAL;
+
+        if (wglSwapIntervalEXT && wglGetExtensionsStringEXT &&
+            HasExtension(wglGetExtensionsStringEXT(), "WGL_EXT_swap_control_tear"))
+            m_SwapControl = m_SwapControl | SwapControl::ADAPTIVE;
+
         return true;
     }
 
@@ -133,6 +215,69 @@ namespace awml {
         wglMakeCurrent(m_Context, m_OpenGLContext);
     }
 
+    void WindowsOpenGLContext::ReleaseCurrent()
+    {
+        if (!m_Context || !m_OpenGLContext)
+            return;
+
+        wglMakeCurrent(NULL, NULL);
+    }
+
+    bool WindowsOpenGLContext::SetSwapInterval(int interval)
+    {
+        if (!EnsureSetup())
+            return false;
+
+        if (!m_OpenGLContext)
+        {
+            m_Parent->NotifyError(error::CONTEXT, "Cannot set the swap interval of a null context!");
+            return false;
+        }
+
+        if (!(m_SwapControl & SwapControl::INTERVAL))
+            return false;
+
+        bool exact = true;
+
+        if (interval < 0 && !(m_SwapControl & SwapControl::ADAPTIVE))
+        {
+            interval = -interval;
+            exact = false;
+        }
+
+        return wglSwapIntervalEXT(interval) && exact;
+    }
+
+    bool WindowsOpenGLContext::SetMaxFramesInFlight(uint32_t frames)
+    {
+        if (!EnsureSetup())
+            return false;
+
+        if (!m_OpenGLContext)
+        {
+            m_Parent->NotifyError(error::CONTEXT, "Cannot limit the frames in flight of a null context!");
+            return false;
+        }
+
+        if (frames && !FrameFences::Supported())
+            return false;
+
+        bool exact = frames <= FrameFences::s_MaxFrames;
+        m_Fences.SetLimit(exact ? frames : static_cast<uint32_t>(FrameFences::s_MaxFrames));
+
+        return exact;
+    }
+
+    std::chrono::nanoseconds WindowsOpenGLContext::GetFrameWaitTime()
+    {
+        return m_Fences.LastWait();
+    }
+
+    SwapControl WindowsOpenGLContext::GetSwapControl()
+    {
+        return m_SwapControl;
+    }
+
     void WindowsOpenGLContext::SwapBuffers()
     {
         if (!m_Context || !m_OpenGLContext)
@@ -142,6 +287,9 @@ namespace awml {
         }
 
         ::SwapBuffers(m_Context);
+
+        if (!m_Fences.EndFrame())
+            m_Parent->NotifyError(error::CONTEXT, "Failed to wait for a frame fence!");
     }
 
     WindowsOpenGLContext::~WindowsOpenGLContext()
@@ -161,7 +309,9 @@ namespace awml {
         Context context,
         WindowMode window_mode,
         CursorMode cursor_mode,
-        bool resizable
+        bool resizable,
+        const FramebufferConfig& framebuffer,
+        const ContextConfig& context_config
     ) : m_ClassName(title),
         m_WindowTitle(title),
         m_WinProps(),
@@ -178,9 +328,15 @@ namespace awml {
         m_MouseX(0),
         m_MouseY(0),
         m_ContextType(context),
+        m_Framebuffer(framebuffer),
+        m_ContextConfig(context_config),
         m_WindowMode(window_mode),
         m_CursorMode(cursor_mode),
-        m_ShouldClose(false)
+        m_ShouldClose(false),
+        m_Coalescer(m_Events),
+        m_Posted(),
+        m_KeysDown(),
+        m_FrameLimiter()
     {
         m_ClassName += std::to_wstring(s_WindowID++);
 
@@ -264,6 +420,20 @@ namespace awml {
         return true;
     }
 
+    bool WindowsWindow::EnableInputThread(const InputThreadConfig& config)
+    {
+        // Win32 delivers window messages to the thread that
+        // created the window, so they can't be read elsewhere.
+        (void)config;
+
+        NotifyError(
+            error::GENERIC,
+            "A dedicated input thread is not supported on Windows!"
+        );
+
+        return false;
+    }
+
     void WindowsWindow::SetWindowMode(WindowMode window_mode)
     {
         static WINDOWPLACEMENT last_placement = { sizeof(last_placement) };
@@ -376,6 +546,9 @@ namespace awml {
         if (!m_Context->Activate())
             return false;
 
+        // Activate made it current on this thread.
+        m_ContextOwner.Acquire();
+
         return true;
     }
 
@@ -385,15 +558,115 @@ namespace awml {
         SetWindowTextW(m_Window, m_WindowTitle.data());
     }
 
+    bool WindowsWindow::SetSwapInterval(int interval)
+    {
+        if (!m_Context)
+        {
+            NotifyError(error::CONTEXT, "The window has no graphics context!");
+            return false;
+        }
+
+        return m_Context->SetSwapInterval(interval);
+    }
+
+    SwapControl WindowsWindow::GetSwapControl()
+    {
+        return m_Context ? m_Context->GetSwapControl() : SwapControl::NONE;
+    }
+
+    bool WindowsWindow::SetMaxFramesInFlight(uint32_t frames)
+    {
+        if (!m_Context)
+        {
+            NotifyError(error::CONTEXT, "The window has no graphics context!");
+            return false;
+        }
+
+        return m_Context->SetMaxFramesInFlight(frames);
+    }
+
+    std::chrono::nanoseconds WindowsWindow::GetFrameWaitTime()
+    {
+        return m_Context ? m_Context->GetFrameWaitTime() : std::chrono::nanoseconds::zero();
+    }
+
+    void WindowsWindow::SetTargetFrameRate(double hz)
+    {
+        m_FrameLimiter.SetRate(hz);
+    }
+
+    FramePacingStats WindowsWindow::GetFramePacingStats()
+    {
+        return m_FrameLimiter.Stats();
+    }
+
     void WindowsWindow::MakeCurrent()
     {
         if (!EnsureAlive())
             return;
 
-        if (m_Context)
-            m_Context->MakeCurrent();
-        else
+        if (!m_Context)
+        {
             NotifyError(error::CONTEXT, "Cannot make NULL context current!");
+            return;
+        }
+
+        if (!m_ContextOwner.Acquire())
+        {
+            NotifyError(
+                error::CONTEXT,
+                "The context is current on another thread, release it there first!"
+            );
+
+            return;
+        }
+
+        m_Context->MakeCurrent();
+    }
+
+    void WindowsWindow::ReleaseCurrent()
+    {
+        if (!m_Context || !m_ContextOwner.IsOwner())
+            return;
+
+        m_Context->ReleaseCurrent();
+        m_ContextOwner.Release();
+    }
+
+    bool WindowsWindow::StartRenderThread(render_callback render)
+    {
+        if (!EnsureAlive())
+            return false;
+
+        if (!m_Context)
+        {
+            NotifyError(error::CONTEXT, "A render thread needs a graphics context!");
+            return false;
+        }
+
+        if (m_RenderThread.Running())
+        {
+            NotifyError(error::GENERIC, "The render thread is already running!");
+            return false;
+        }
+
+        // Handed over from the calling thread.
+        ReleaseCurrent();
+        if (!m_RenderThread.Start(*this, m_ContextOwner, render))
+        {
+            // Reported on the render thread if there was a callback.
+            if (!m_RenderThread.Error().empty())
+                NotifyError(error::CONTEXT, m_RenderThread.Error());
+
+            return false;
+        }
+
+        return true;
+    }
+
+    void WindowsWindow::StopRenderThread()
+    {
+        m_RenderThread.Stop();
     }
 
     bool WindowsWindow::EnsureAlive()
@@ -407,16 +680,104 @@ namespace awml {
         return true;
     }
 
-    void WindowsWindow::PollEvents()
+    bool WindowsWindow::BeginPoll()
+    {
+        return EnsureAlive();
+    }
+
+    int WindowsWindow::GetEventFd()
+    {
+        // Windows message queues aren't backed by a
+        // descriptor, MsgWaitForMultipleObjects is the
+        // equivalent there.
+        return -1;
+    }
+
+    void WindowsWindow::Flush()
+    {
+        // Nothing is buffered on the client side.
+    }
+
+    void WindowsWindow::WaitEvents()
     {
         if (!EnsureAlive()) return;
 
+        if (m_Events.Empty())
+            WaitMessage();
+
+        PollEvents();
+    }
+
+    void WindowsWindow::WaitEventsTimeout(std::chrono::nanoseconds timeout)
+    {
+        if (!EnsureAlive()) return;
+
+        if (m_Events.Empty() && timeout.count() > 0)
+        {
+            // Round up so sub-millisecond timeouts still sleep.
+            auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(
+                timeout + std::chrono::milliseconds(1) - std::chrono::nanoseconds(1)
+            );
+
+            MsgWaitForMultipleObjectsEx(
+                0, NULL,
+                static_cast<DWORD>(millis.count()),
+                QS_ALLINPUT,
+                MWMO_INPUTAVAILABLE
+            );
+        }
+
+        PollEvents();
+    }
+
+    bool WindowsWindow::PumpEvents()
+    {
+        // A single message can decode into two awml events
+        // (key press + typed char), and the coalescer might
+        // be holding back a couple more.
         auto message = MSG();
-        while (PeekMessageW(&message, NULL, 0, 0, PM_REMOVE))
+        bool more = true;
+
+        Event posted;
+
+        while (m_Events.Space() > EventCoalescer::s_MaxHeld && m_Posted.Pop(posted))
+            m_Coalescer.Stage(posted);
+
+        while (m_Events.Space() >= 2 + EventCoalescer::s_MaxHeld)
         {
+            if (!PeekMessageW(&message, NULL, 0, 0, PM_REMOVE))
+            {
+                more = false;
+                break;
+            }
+
             TranslateMessage(&message);
             DispatchMessageW(&message);
         }
+
+        m_Coalescer.Flush();
+
+        return more;
+    }
+
+    void WindowsWindow::PushEvent(Event event)
+    {
+        event.timestamp = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()
+            ).count()
+        );
+        event.count = 1;
+
+        // Messages sent to the window outside of PumpEvents
+        // (e.g. by SetWindowPos) are queued as well and get
+        // dispatched with the next poll. If nobody drains the
+        // queue the newest events are dropped.
+        m_Coalescer.Stage(event);
+
+        // Messages are handled on the polling thread,
+        // so the snapshot can be built right here.
+        m_Input.Apply(event);
     }
 
     void WindowsWindow::SwapBuffers()
@@ -425,23 +786,25 @@ namespace awml {
 
         if (m_Context)
             m_Context->SwapBuffers();
+
+        m_Awaiters.EndFrame();
     }
 
     void WindowsWindow::Update()
     {
         if (!EnsureAlive()) return;
 
+        m_FrameLimiter.Wait();
+
         PollEvents();
         SwapBuffers();
     }
 
-    bool WindowsWindow::ShouldClose()
-    {
-        return m_ShouldClose;
-    }
-
     void WindowsWindow::Close()
     {
+        StopRenderThread();
+        StopRecording();
+
         if (m_Window)
         {
             DestroyWindow(m_Window);
@@ -449,90 +812,133 @@ namespace awml {
         }
     }
 
-    uint16_t WindowsWindow::GetWidth()
+    void WindowsWindow::OnKeyPressed(key_pressed_callback cb)
+    {
+        m_Callbacks.key_pressed = cb;
+    }
+
+    void WindowsWindow::OnKeyReleased(key_released_callback cb)
+    {
+        m_Callbacks.key_released = cb;
+    }
+
+    void WindowsWindow::OnWindowResized(window_resized_callback cb)
     {
-        return m_RunningWidth;
+        m_Callbacks.window_resized = cb;
     }
 
-    uint16_t WindowsWindow::GetHeight()
+    void WindowsWindow::OnWindowClosed(window_closed_callback cb)
     {
-        return m_RunningHeight;
+        m_Callbacks.window_closed = cb;
     }
 
-    uint16_t WindowsWindow::GetMouseX()
+    void WindowsWindow::OnMouseMoved(mouse_moved_callback cb)
     {
-        return m_MouseX;
+        m_Callbacks.mouse_moved = cb;
     }
-    
-    uint16_t WindowsWindow::GetMouseY()
+
+    void WindowsWindow::OnMousePressed(mouse_pressed_callback cb)
     {
-        return m_MouseY;
+        m_Callbacks.mouse_pressed = cb;
     }
 
-    std::pair<uint16_t, uint16_t> WindowsWindow::GetMouseCoords()
+    void WindowsWindow::OnMouseReleased(mouse_released_callback cb)
     {
-        return { m_MouseX, m_MouseY };
+        m_Callbacks.mouse_released = cb;
     }
 
-    void WindowsWindow::OnError(error_callback cb)
+    void WindowsWindow::OnMouseScrolled(mouse_scrolled_callback cb)
     {
-        m_ErrorCB = cb;
+        m_Callbacks.mouse_scrolled = cb;
     }
 
-    void WindowsWindow::OnKeyPressed(key_pressed_callback cb)
+    void WindowsWindow::OnCharTyped(char_typed_callback cb)
     {
-        m_KeyPressedCB = cb;
+        m_Callbacks.char_typed = cb;
     }
 
-    void WindowsWindow::OnKeyReleased(key_released_callback cb)
+    void WindowsWindow::OnUserEvent(user_event_callback cb)
     {
-        m_KeyReleasedCB = cb;
+        m_Callbacks.user_event = cb;
     }
 
-    void WindowsWindow::OnWindowResized(window_resized_callback cb)
+    void WindowsWindow::SetCallbackExecutor(
+        EventType type,
+        callback_executor executor
+    )
     {
-        m_WindowResizedCB = cb;
+        if (!m_Callbacks.SetExecutor(type, executor))
+            NotifyError(error::ARGS, "There is no callback for this event type!");
     }
 
-    void WindowsWindow::OnWindowClosed(window_closed_callback cb)
+    bool WindowsWindow::PostEvent(const UserEvent& user)
     {
-        m_WindowClosedCB = cb;
+        Event event;
+        event.type = EventType::USER;
+        event.count = 1;
+        event.timestamp = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()
+            ).count()
+        );
+        event.user = user;
+
+        if (!m_Posted.Push(event))
+            return false;
+
+        Wakeup();
+
+        return true;
     }
 
-    void WindowsWindow::OnMouseMoved(mouse_moved_callback cb)
+    void WindowsWindow::Wakeup()
     {
-        m_MouseMovedCB = cb;
+        // Any message makes the waits in WaitEvents
+        // and the event loop return.
+        if (m_Window)
+            PostMessageW(m_Window, WM_NULL, 0, 0);
     }
 
-    void WindowsWindow::OnMousePressed(mouse_pressed_callback cb)
+    void WindowsWindow::SelectEvents(event_mask mask)
     {
-        m_MousePressedCB = cb;
+        // Win32 always sends every message to the window
+        // procedure, there is nothing to subscribe to.
+        (void)mask;
     }
 
-    void WindowsWindow::OnMouseReleased(mouse_released_callback cb)
+    bool WindowsWindow::StartRecording(const std::string& path)
     {
-        m_MouseReleasedCB = cb;
+        if (!m_Recorder.Start(path, m_RunningWidth, m_RunningHeight))
+        {
+            NotifyError(error::GENERIC, "Failed to create the event log!");
+            return false;
+        }
+
+        return true;
     }
 
-    void WindowsWindow::OnMouseScrolled(mouse_scrolled_callback cb)
+    void WindowsWindow::StopRecording()
     {
-        m_MouseScrolledCB = cb;
+        m_Recorder.Stop();
     }
 
-    void WindowsWindow::OnCharTyped(char_typed_callback cb)
+    void WindowsWindow::SetEventCoalescing(Coalesce mode)
     {
-        m_CharTypedCB = cb;
+        m_Coalescer.SetMode(mode);
     }
 
     bool WindowsWindow::IsKeyPressed(awml_key key_code)
     {
+        if (key_code == awml_key::UNKNOWN || key_code >= awml_key::COUNT)
+            return false;
+
         return AWML_KEY_PRESSED_BIT &
-            GetKeyState(static_cast<int>(key_code));
+            GetKeyState(s_VirtualKeyTable[key_code]);
     }
 
-    bool WindowsWindow::Minimized()
+    const InputSnapshot& WindowsWindow::BeginFrame()
     {
-        return !m_RunningWidth && !m_RunningHeight;
+        return m_Input.Publish(m_KeysDown);
     }
 
     void WindowsWindow::SetCursorMode(CursorMode cursor_mode)
@@ -584,9 +990,26 @@ namespace awml {
         }
     }
 
+    void WindowsWindow::Suspend(AwaitNode& node)
+    {
+        // Every event is queued here, there is no mask to update.
+        m_Awaiters.Push(node);
+    }
+
+    void* WindowsWindow::AllocateCoroutine(size_t size)
+    {
+        return m_Awaiters.Arena().Allocate(size);
+    }
+
+    void WindowsWindow::FreeCoroutine(void* frame, size_t size)
+    {
+        m_Awaiters.Arena().Free(frame, size);
+    }
+
     WindowsWindow::~WindowsWindow()
     {
         Close();
+        m_Awaiters.DestroySuspended();
     }
 
     void WindowsWindow::RecalculateNative()
@@ -611,15 +1034,6 @@ namespace awml {
         );
     }
 
-    void WindowsWindow::NotifyError(error code, const std::string& message)
-    {
-        if (m_ErrorCB)
-            m_ErrorCB(code, message);
-        else
-            // TODO: Replace with an awml specific error class
-            throw std::runtime_error(message);
-    }
-
     void WindowsWindow::OnWindowResized(WORD width, WORD height)
     {
         // We have to check whether resizing
@@ -657,8 +1071,10 @@ namespace awml {
         m_RunningWidth = width;
         m_RunningHeight = height;
 
-        if (m_WindowResizedCB)
-            m_WindowResizedCB(width, height);
+        Event event;
+        event.type = EventType::WINDOW_RESIZED;
+        event.size = { width, height };
+        PushEvent(event);
 
         resizing = false;
     }
@@ -670,8 +1086,9 @@ namespace awml {
             SetResolution(m_NativeWidth, m_NativeHeight);
         }
 
-        if (m_WindowClosedCB)
-            m_WindowClosedCB();
+        // The window is gone after this, there won't
+        // be another poll to deliver a queued event.
+        m_Callbacks.OnWindowClosed();
     }
 
     void WindowsWindow::OnMouseMoved(WORD xpos, WORD ypos)
@@ -688,21 +1105,31 @@ namespace awml {
             m_MouseX = xpos;
             m_MouseY = ypos;
 
-            if (m_MouseMovedCB)
-                m_MouseMovedCB(m_MouseX, m_MouseY);
+            Event event;
+            event.type = EventType::MOUSE_MOVED;
+            event.mouse = { m_MouseX, m_MouseY };
+            PushEvent(event);
         }
     }
 
     void WindowsWindow::OnMousePressed(awml_key code)
     {
-        if (m_MousePressedCB)
-            m_MousePressedCB(code);
+        Event event;
+        event.type = EventType::MOUSE_PRESSED;
+        event.button = { code };
+        PushEvent(event);
+
+        m_KeysDown.Set(code);
     }
 
     void WindowsWindow::OnMouseReleased(awml_key code)
     {
-        if (m_MouseReleasedCB)
-            m_MouseReleasedCB(code);
+        Event event;
+        event.type = EventType::MOUSE_RELEASED;
+        event.button = { code };
+        PushEvent(event);
+
+        m_KeysDown.Reset(code);
     }
 
     void WindowsWindow::OnMouseScrolled(int16_t rotation, bool vertical)
@@ -713,31 +1140,38 @@ namespace awml {
         if      (rotation >  10) rotation =  10;
         else if (rotation < -10) rotation = -10;
 
-        if (m_MouseScrolledCB)
-            m_MouseScrolledCB(rotation, vertical);
+        Event event;
+        event.type = EventType::MOUSE_SCROLLED;
+        event.scroll = { rotation, vertical };
+        PushEvent(event);
     }
 
-    void WindowsWindow::OnKeyPressed(WPARAM key_code, bool repeated, uint16_t repeat_count)
+    void WindowsWindow::OnKeyPressed(awml_key key_code, bool repeated, uint16_t repeat_count)
     {
-        if (m_KeyPressedCB)
-            m_KeyPressedCB(
-                static_cast<awml_key>(key_code),
-                repeated, repeat_count
-            );
+        Event event;
+        event.type = EventType::KEY_PRESSED;
+        event.key = { key_code, repeat_count, repeated };
+        PushEvent(event);
+
+        m_KeysDown.Set(key_code);
     }
 
-    void WindowsWindow::OnKeyReleased(WPARAM key_code)
+    void WindowsWindow::OnKeyReleased(awml_key key_code)
     {
-        if (m_KeyReleasedCB)
-            m_KeyReleasedCB(
-                static_cast<awml_key>(key_code)
-            );
+        Event event;
+        event.type = EventType::KEY_RELEASED;
+        event.key = { key_code, 0, false };
+        PushEvent(event);
+
+        m_KeysDown.Reset(key_code);
     }
 
     void WindowsWindow::OnCharTyped(wchar_t typed_char)
     {
-        if (m_CharTypedCB)
-            m_CharTypedCB(typed_char);
+        Event event;
+        event.type = EventType::CHAR_TYPED;
+        event.text = { typed_char };
+        PushEvent(event);
     }
 
     void WindowsWindow::SetResolution(uint16_t width, uint16_t height)
@@ -775,11 +1209,46 @@ namespace awml {
         );
     }
 
+    const FramebufferConfig& WindowsWindow::GetFramebufferConfig()
+    {
+        return m_Framebuffer;
+    }
+
+    const ContextConfig& WindowsWindow::GetContextConfig()
+    {
+        return m_ContextConfig;
+    }
+
     void* WindowsWindow::GetNativeHandle()
     {
         return m_Window;
     }
 
+    awml_key WindowsWindow::TranslateKey(WPARAM virtual_key, LPARAM flags)
+    {
+        // WM_KEYDOWN/WM_KEYUP only carry the generic
+        // modifier codes, the side comes from the flags.
+        switch (virtual_key)
+        {
+        case VK_SHIFT:
+            virtual_key = MapVirtualKeyW(
+                (flags >> AWML_SCAN_CODE_SHIFT) & 0xFF,
+                MAPVK_VSC_TO_VK_EX
+            );
+            break;
+        case VK_CONTROL:
+            virtual_key = flags & AWML_EXTENDED_KEY_BIT ? VK_RCONTROL : VK_LCONTROL;
+            break;
+        case VK_MENU:
+            virtual_key = flags & AWML_EXTENDED_KEY_BIT ? VK_RMENU : VK_LMENU;
+            break;
+        default:
+            break;
+        }
+
+        return s_VirtualKeyLookup[virtual_key];
+    }
+
     LRESULT CALLBACK WindowsWindow::WindowEventHandler(
         HWND window,
         UINT message,
@@ -847,13 +1316,13 @@ namespace awml {
             break;
         case WM_KEYDOWN:
             owner->OnKeyPressed(
-                param_1,
+                TranslateKey(param_1, param_2),
                 param_2 & AWML_REPEATED_BIT,
                 param_2 & AWML_REPEAT_COUNT_MASK
             );
             break;
         case WM_KEYUP:
-            owner->OnKeyReleased(param_1);
+            owner->OnKeyReleased(TranslateKey(param_1, param_2));
             break;
         case WM_CHAR:
             owner->OnCharTyped(static_cast<wchar_t>(param_1));
@@ -865,6 +1334,9 @@ namespace awml {
             );
             break;
         case WM_KILLFOCUS:
+            // Releases that happen while unfocused never reach us.
+            owner->m_KeysDown = KeySet();
+
             if (owner->m_WindowMode == WindowMode::FULLSCREEN)
             {
                 owner->SetResolution(
@@ -8,6 +8,14 @@
 
 #include "awml.h"
 
+#include "EventCoalescer.h"
+#include "EventWindow.h"
+#include "MPSCQueue.h"
+#include "FrameFences.h"
+#include "FrameLimiter.h"
+#include "RenderThread.h"
+#include "utilities.h"
+
 namespace awml {
 
     class WindowsWindow;
@@ -19,6 +27,10 @@ namespace awml {
         HGLRC m_OpenGLContext;
         WindowsWindow* m_Parent;
         int m_Format;
+
+        SwapControl m_SwapControl;
+
+        FrameFences m_Fences;
     public:
         WindowsOpenGLContext();
 
@@ -26,13 +38,20 @@ namespace awml {
         bool Activate() override;
         void SwapBuffers() override;
         void MakeCurrent() override;
+        void ReleaseCurrent() override;
+
+        bool SetSwapInterval(int interval) override;
+        SwapControl GetSwapControl() override;
+
+        bool SetMaxFramesInFlight(uint32_t frames) override;
+        std::chrono::nanoseconds GetFrameWaitTime() override;
 
         ~WindowsOpenGLContext();
     private:
         bool EnsureSetup();
     };
 
-    class WindowsWindow : public Window
+    class WindowsWindow final : public EventWindow
     {
     private:
         friend class WindowsOpenGLContext;
@@ -50,6 +69,15 @@ namespace awml {
         Context        m_ContextType;
         window_context m_Context;
 
+        ContextOwner m_ContextOwner;
+        RenderThread m_RenderThread;
+
+        // Requested, then chosen by WindowsOpenGLContext::Setup.
+        FramebufferConfig m_Framebuffer;
+
+        // Requested, then read back by WindowsOpenGLContext::Activate.
+        ContextConfig m_ContextConfig;
+
         uint16_t m_OriginalWidth;
         uint16_t m_OriginalHeight;
 
@@ -70,16 +98,17 @@ namespace awml {
 
         bool m_ShouldClose;
 
-        error_callback          m_ErrorCB;
-        key_pressed_callback    m_KeyPressedCB;
-        key_released_callback   m_KeyReleasedCB;
-        window_resized_callback m_WindowResizedCB;
-        window_closed_callback  m_WindowClosedCB;
-        mouse_moved_callback    m_MouseMovedCB;
-        mouse_pressed_callback  m_MousePressedCB;
-        mouse_released_callback m_MouseReleasedCB;
-        mouse_scrolled_callback m_MouseScrolledCB;
-        char_typed_callback     m_CharTypedCB;
+        EventCoalescer m_Coalescer;
+
+        // Events posted from other threads, moved
+        // into the event queue by PumpEvents.
+        MPSCQueue<Event, AWML_USER_EVENT_QUEUE_SIZE> m_Posted;
+
+        // Keys and mouse buttons held, kept from the
+        // messages for the input snapshots.
+        KeySet m_KeysDown;
+
+        FrameLimiter m_FrameLimiter;
     public:
         WindowsWindow(
             const std::wstring& title,
@@ -88,24 +117,54 @@ namespace awml {
             Context context,
             WindowMode window_mode,
             CursorMode cursor_mode,
-            bool resizable
+            bool resizable,
+            const FramebufferConfig& framebuffer = FramebufferConfig(),
+            const ContextConfig& context_config = ContextConfig()
         );
 
 
         bool Launch() override;
 
+        bool EnableInputThread(const InputThreadConfig& config) override;
+
         bool SetContext(window_context wc) override;
 
         void SetTitle(const std::wstring& title) override;
 
         void MakeCurrent() override;
 
-        void PollEvents() override;
+        void ReleaseCurrent() override;
+
+        bool StartRenderThread(render_callback render) override;
+
+        void StopRenderThread() override;
+
+        void Suspend(AwaitNode& node) override;
+
+        void* AllocateCoroutine(size_t size) override;
+        void FreeCoroutine(void* frame, size_t size) override;
+
+        int GetEventFd() override;
+
+        void Flush() override;
+
+        void WaitEvents() override;
+
+        void WaitEventsTimeout(std::chrono::nanoseconds timeout) override;
 
         void SwapBuffers() override;
 
         void Update() override;
 
+        bool SetSwapInterval(int interval) override;
+        SwapControl GetSwapControl() override;
+
+        void SetTargetFrameRate(double hz) override;
+        FramePacingStats GetFramePacingStats() override;
+
+        bool SetMaxFramesInFlight(uint32_t frames) override;
+        std::chrono::nanoseconds GetFrameWaitTime() override;
+
         bool ShouldClose() override;
 
         void Close() override;
@@ -120,10 +179,6 @@ namespace awml {
 
         uint16_t GetMouseY() override;
 
-        void OnError(
-            error_callback cb
-        ) override;
-
         void OnKeyPressed(
             key_pressed_callback cb
         ) override;
@@ -160,10 +215,33 @@ namespace awml {
             char_typed_callback cb
         ) override;
 
+        void OnUserEvent(
+            user_event_callback cb
+        ) override;
+
+        void SetCallbackExecutor(
+            EventType type,
+            callback_executor executor
+        ) override;
+
+        bool PostEvent(const UserEvent& event) override;
+
+        void Wakeup() override;
+
+        void SetEventCoalescing(Coalesce mode) override;
+
+        void SelectEvents(event_mask mask) override;
+
+        bool StartRecording(const std::string& path) override;
+
+        void StopRecording() override;
+
         bool Minimized() override;
 
         bool IsKeyPressed(awml_key key_code) override;
 
+        const InputSnapshot& BeginFrame() override;
+
         void SetCursorMode(CursorMode cursor_mode) override;
 
         void SetWindowMode(WindowMode window_mode) override;
@@ -172,6 +250,10 @@ namespace awml {
 
         void* GetNativeHandle() override;
 
+        const FramebufferConfig& GetFramebufferConfig() override;
+
+        const ContextConfig& GetContextConfig() override;
+
         ~WindowsWindow();
     private:
         bool EnsureAlive();
@@ -180,7 +262,10 @@ namespace awml {
 
         void RecalculateNative();
 
-        void NotifyError(error code, const std::string& msg);
+        bool BeginPoll() override;
+        bool PumpEvents() override;
+
+        void PushEvent(Event event);
 
         void OnWindowResized(WORD width, WORD height);
 
@@ -194,12 +279,14 @@ namespace awml {
 
         void OnMouseScrolled(int16_t rotation, bool vertical);
 
-        void OnKeyPressed(WPARAM key_code, bool repeated, uint16_t repeat_count);
+        void OnKeyPressed(awml_key key_code, bool repeated, uint16_t repeat_count);
 
-        void OnKeyReleased(WPARAM key_code);
+        void OnKeyReleased(awml_key key_code);
 
         void OnCharTyped(wchar_t typed_char);
 
+        static awml_key TranslateKey(WPARAM virtual_key, LPARAM flags);
+
         static LRESULT CALLBACK WindowEventHandler(
             HWND window,
             UINT message,
@@ -207,4 +294,39 @@ namespace awml {
             LPARAM param_2
         );
     };
+
+    inline bool WindowsWindow::ShouldClose()
+    {
+        return m_ShouldClose;
+    }
+
+    inline uint16_t WindowsWindow::GetWidth()
+    {
+        return m_RunningWidth;
+    }
+
+    inline uint16_t WindowsWindow::GetHeight()
+    {
+        return m_RunningHeight;
+    }
+
+    inline uint16_t WindowsWindow::GetMouseX()
+    {
+        return m_MouseX;
+    }
+
+    inline uint16_t WindowsWindow::GetMouseY()
+    {
+        return m_MouseY;
+    }
+
+    inline std::pair<uint16_t, uint16_t> WindowsWindow::GetMouseCoords()
+    {
+        return { m_MouseX, m_MouseY };
+    }
+
+    inline bool WindowsWindow::Minimized()
+    {
+        return !m_RunningWidth && !m_RunningHeight;
+    }
 }
@@ -0,0 +1,306 @@
+#include <algorithm>
+#include <mutex>
+
+#include <X11/XKBlib.h>
+
+#include "XConnection.h"
+#include "XWindow.h"
+
+namespace awml {
+
+    static std::mutex                 s_ConnectionLock;
+    static std::weak_ptr<XConnection> s_Connection;
+
+    XWindowTable::XWindowTable()
+        : m_Entries(16, Entry { 0, nullptr }),
+        m_Count(0)
+    {
+    }
+
+    size_t XWindowTable::Slot(::Window xid) const
+    {
+        // Fibonacci hashing, XIDs of one client only
+        // differ in their low bits.
+        uint64_t hash = static_cast<uint64_t>(xid) * 0x9E3779B97F4A7C15ull;
+
+        return static_cast<size_t>(hash >> 32) & (m_Entries.size() - 1);
+    }
+
+    XWindow* XWindowTable::Find(::Window xid) const
+    {
+        size_t mask = m_Entries.size() - 1;
+
+        for (size_t i = Slot(xid);; i = (i + 1) & mask)
+        {
+            const Entry& entry = m_Entries[i];
+
+            if (!entry.window)
+                return nullptr;
+
+            if (entry.xid == xid)
+                return entry.window;
+        }
+    }
+
+    void XWindowTable::Insert(::Window xid, XWindow* window)
+    {
+        // Kept at most half full so probes stay short.
+        if ((m_Count + 1) * 2 > m_Entries.size())
+            Rehash(m_Entries.size() * 2);
+
+        size_t mask = m_Entries.size() - 1;
+        size_t i = Slot(xid);
+
+        while (m_Entries[i].window && m_Entries[i].xid != xid)
+            i = (i + 1) & mask;
+
+        if (!m_Entries[i].window)
+            ++m_Count;
+
+        m_Entries[i] = { xid, window };
+    }
+
+    void XWindowTable::Erase(::Window xid)
+    {
+        size_t mask = m_Entries.size() - 1;
+        size_t i = Slot(xid);
+
+        while (m_Entries[i].window && m_Entries[i].xid != xid)
+            i = (i + 1) & mask;
+
+        if (!m_Entries[i].window)
+            return;
+
+        // Shifts the rest of the probe run back instead of leaving
+        // a tombstone, so lookups never have to skip over holes.
+        for (size_t j = (i + 1) & mask; m_Entries[j].window; j = (j + 1) & mask)
+        {
+            size_t home = Slot(m_Entries[j].xid);
+
+            if (((j - home) & mask) >= ((j - i) & mask))
+            {
+                m_Entries[i] = m_Entries[j];
+                i = j;
+            }
+        }
+
+        m_Entries[i] = { 0, nullptr };
+        --m_Count;
+    }
+
+    void XWindowTable::Rehash(size_t capacity)
+    {
+        std::vector<Entry> entries(capacity, Entry { 0, nullptr });
+        entries.swap(m_Entries);
+
+        m_Count = 0;
+
+        for (const auto& entry : entries)
+        {
+            if (entry.window)
+                Insert(entry.xid, entry.window);
+        }
+    }
+
+    XEventRouter::XEventRouter()
+        : m_Windows(),
+        m_KeymapTarget(nullptr)
+    {
+    }
+
+    XWindow* XEventRouter::Route(const XEvent& event)
+    {
+        if (event.type == KeymapNotify)
+            return m_KeymapTarget;
+
+        XWindow* window = m_Windows.Find(event.xany.window);
+
+        if (event.type == FocusIn || event.type == EnterNotify)
+            m_KeymapTarget = window;
+
+        return window;
+    }
+
+    void XEventRouter::Insert(::Window xid, XWindow* window)
+    {
+        m_Windows.Insert(xid, window);
+    }
+
+    void XEventRouter::Erase(::Window xid)
+    {
+        XWindow* window = m_Windows.Find(xid);
+
+        if (!window)
+            return;
+
+        if (window == m_KeymapTarget)
+            m_KeymapTarget = nullptr;
+
+        m_Held.erase(
+            std::remove_if(
+                m_Held.begin(),
+                m_Held.end(),
+                [window](const Held& held) { return held.window == window; }
+            ),
+            m_Held.end()
+        );
+
+        m_Windows.Erase(xid);
+    }
+
+    size_t XEventRouter::HeldEvents(XWindow* window)
+    {
+        Held* held = FindHeld(window);
+
+        return held ? held->events.size() : 0;
+    }
+
+    XEventRouter::Held* XEventRouter::FindHeld(XWindow* window)
+    {
+        for (auto& held : m_Held)
+        {
+            if (held.window == window)
+                return &held;
+        }
+
+        return nullptr;
+    }
+
+    void XEventRouter::Hold(XWindow* window, const XEvent& event)
+    {
+        Held* held = FindHeld(window);
+
+        if (!held)
+        {
+            m_Held.push_back(Held { window, std::deque<XEvent>() });
+            held = &m_Held.back();
+        }
+
+        held->events.push_back(event);
+    }
+
+    XConnection::XConnection(Display* display)
+        : m_Display(display)
+    {
+    }
+
+    std::shared_ptr<XConnection> XConnection::Acquire(std::string& error)
+    {
+        std::lock_guard<std::mutex> lock(s_ConnectionLock);
+
+        auto connection = s_Connection.lock();
+
+        if (connection)
+            return connection;
+
+        // Xlib has to be told about threads before any other call is
+        // made, and any window may start an input or render thread
+        // later on. Uncontended, the locking costs next to nothing.
+        if (!XInitThreads())
+        {
+            error = "Failed to initialize Xlib for multithreaded use!";
+            return nullptr;
+        }
+
+        Display* display = XOpenDisplay(NULL);
+
+        if (!display)
+        {
+            error = "Could not establish connection with the X server!";
+            return nullptr;
+        }
+
+        XkbSetDetectableAutoRepeat(display, true, NULL);
+
+        connection.reset(new XConnection(display));
+        s_Connection = connection;
+
+        return connection;
+    }
+
+    void XConnection::Register(::Window xid, XWindow* window)
+    {
+        XLockDisplay(m_Display);
+        m_Router.Insert(xid, window);
+        XUnlockDisplay(m_Display);
+    }
+
+    void XConnection::Unregister(::Window xid)
+    {
+        XLockDisplay(m_Display);
+        m_Router.Erase(xid);
+        XUnlockDisplay(m_Display);
+    }
+
+    bool XConnection::Pump(XWindow* self)
+    {
+        auto decode = [](XWindow* window, const XEvent& event)
+        {
+            if (!window->CanDecode())
+                return false;
+
+            window->DecodeEvent(event);
+            return true;
+        };
+
+        XEvent event;
+
+        XLockDisplay(m_Display);
+
+        // What was held back came before anything in the Xlib queue.
+        if (m_Router.Release(self, decode))
+            m_Touched.push_back(self);
+
+        while (XQLength(m_Display))
+        {
+            XNextEvent(m_Display, &event);
+
+            if (event.type == MappingNotify)
+            {
+                // Always delivered and not tied to a window,
+                // every window reloads its key table.
+                if (event.xmapping.request == MappingKeyboard)
+                {
+                    XRefreshKeyboardMapping(&event.xmapping);
+                    m_Router.ForEach([](XWindow* window) { window->LoadKeyTable(); });
+                }
+
+                continue;
+            }
+
+            XWindow* window = m_Router.Deliver(event, decode);
+
+            // Leftovers of a window that was already closed.
+            if (!window)
+                continue;
+
+            if (std::find(m_Touched.begin(), m_Touched.end(), window) == m_Touched.end())
+                m_Touched.push_back(window);
+        }
+
+        bool blocked = m_Router.HeldEvents(self) > 0;
+
+        for (auto window : m_Touched)
+            window->FinishPump(window != self);
+
+        m_Touched.clear();
+
+        XUnlockDisplay(m_Display);
+
+        return blocked;
+    }
+
+    size_t XConnection::HeldEvents(XWindow* window)
+    {
+        XLockDisplay(m_Display);
+        size_t held = m_Router.HeldEvents(window);
+        XUnlockDisplay(m_Display);
+
+        return held;
+    }
+
+    XConnection::~XConnection()
+    {
+        XCloseDisplay(m_Display);
+    }
+}
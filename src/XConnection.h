@@ -0,0 +1,166 @@
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <X11/Xlib.h>
+
+namespace awml {
+
+    class XWindow;
+
+    // XID -> XWindow lookup, open addressing with linear probing
+    // so routing an event is a multiply and a short scan.
+    class XWindowTable
+    {
+    private:
+        struct Entry
+        {
+            ::Window xid;
+            XWindow* window;
+        };
+
+        std::vector<Entry> m_Entries;
+        size_t             m_Count;
+    public:
+        XWindowTable();
+
+        XWindow* Find(::Window xid) const;
+
+        void Insert(::Window xid, XWindow* window);
+        void Erase(::Window xid);
+
+        template<typename F>
+        void ForEach(F f) const
+        {
+            for (const auto& entry : m_Entries)
+            {
+                if (entry.window)
+                    f(entry.window);
+            }
+        }
+    private:
+        size_t Slot(::Window xid) const;
+        void Rehash(size_t capacity);
+    };
+
+    // Finds the window an event belongs to. KeymapNotify is the odd one
+    // out, Xlib leaves its window None since X sends it right after the
+    // FocusIn or EnterNotify of the window it's meant for.
+    //
+    // Events of a window whose queue is full are held back for it, so
+    // a window that isn't polled doesn't stall the others. They're kept
+    // in order and the window gets them first when it pumps again.
+    class XEventRouter
+    {
+    private:
+        struct Held
+        {
+            XWindow*           window;
+            std::deque<XEvent> events;
+        };
+
+        XWindowTable m_Windows;
+        XWindow*     m_KeymapTarget;
+
+        std::vector<Held> m_Held;
+    public:
+        XEventRouter();
+
+        // Null for events of windows that are gone.
+        XWindow* Route(const XEvent& event);
+
+        // Routes event and hands it to decode(window, event), which
+        // returns false if the window's queue is full. The event is
+        // held then, and so is everything after it for that window.
+        // Returns the window like Route.
+        template<typename Decode>
+        XWindow* Deliver(const XEvent& event, Decode decode)
+        {
+            XWindow* window = Route(event);
+
+            if (!window)
+                return nullptr;
+
+            Held* held = FindHeld(window);
+
+            if (held && !held->events.empty())
+                held->events.push_back(event);
+            else if (!decode(window, event))
+                Hold(window, event);
+
+            return window;
+        }
+
+        // Decodes the held events of window until its queue is full
+        // again, returns how many were.
+        template<typename Decode>
+        size_t Release(XWindow* window, Decode decode)
+        {
+            Held* held = FindHeld(window);
+            size_t released = 0;
+
+            while (held && !held->events.empty() && decode(window, held->events.front()))
+            {
+                held->events.pop_front();
+                ++released;
+            }
+
+            return released;
+        }
+
+        size_t HeldEvents(XWindow* window);
+
+        void Insert(::Window xid, XWindow* window);
+        void Erase(::Window xid);
+
+        template<typename F>
+        void ForEach(F f) const
+        {
+            m_Windows.ForEach(f);
+        }
+    private:
+        Held* FindHeld(XWindow* window);
+        void Hold(XWindow* window, const XEvent& event);
+    };
+
+    // The X server connection shared by all windows of the process.
+    // Events are read from the single socket once and routed to
+    // the window they belong to by XID, whichever window polls.
+    class XConnection
+    {
+    private:
+        Display* m_Display;
+
+        XEventRouter m_Router;
+
+        // Windows that got events during the current Pump.
+        std::vector<XWindow*> m_Touched;
+    public:
+        // Returns the shared connection, opening it on first use.
+        static std::shared_ptr<XConnection> Acquire(std::string& error);
+
+        XConnection(const XConnection& other) = delete;
+        XConnection& operator=(const XConnection& other) = delete;
+
+        Display* GetDisplay() const { return m_Display; }
+
+        void Register(::Window xid, XWindow* window);
+        void Unregister(::Window xid);
+
+        // Decodes the events sitting in the Xlib queue into the queues
+        // of their windows, self's held events first. Returns true if
+        // self's queue filled up so the caller knows to consume and
+        // pump again.
+        bool Pump(XWindow* self);
+
+        // Events held back for window while its queue was full.
+        size_t HeldEvents(XWindow* window);
+
+        ~XConnection();
+    private:
+        explicit XConnection(Display* display);
+    };
+}
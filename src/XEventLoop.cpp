@@ -0,0 +1,375 @@
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+
+#include "XEventLoop.h"
+#include "utilities.h"
+
+// Amount of ready fds handled per epoll_wait.
+#define AWML_EPOLL_BATCH_SIZE 32
+
+namespace awml {
+
+    static timespec ToTimespec(std::chrono::nanoseconds duration)
+    {
+        timespec result;
+        result.tv_sec  = static_cast<time_t>(duration.count() / 1000000000);
+        result.tv_nsec = static_cast<long>(duration.count() % 1000000000);
+
+        return result;
+    }
+
+    XEventLoop::XEventLoop()
+        : m_Epoll(epoll_create1(EPOLL_CLOEXEC)),
+        m_WakeFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+        m_NextTimer(1),
+        m_Stopped(false)
+    {
+        if (m_Epoll < 0 || m_WakeFd < 0)
+            return;
+
+        auto wake = std::make_shared<Source>();
+        wake->type = SourceType::WAKE;
+
+        Register(m_WakeFd, EPOLLIN, wake);
+    }
+
+    void XEventLoop::OnError(error_callback cb)
+    {
+        m_ErrorCB = cb;
+    }
+
+    bool XEventLoop::EnsureValid()
+    {
+        if (m_Epoll < 0 || m_WakeFd < 0)
+        {
+            NotifyError(error::GENERIC, "Failed to create the event loop!");
+            return false;
+        }
+
+        return true;
+    }
+
+    void XEventLoop::NotifyError(error code, const std::string& message)
+    {
+        ReportError(m_ErrorCB, code, message);
+    }
+
+    bool XEventLoop::Register(int fd, uint32_t events, std::shared_ptr<Source> source)
+    {
+        epoll_event event = {};
+        event.events = events;
+        event.data.fd = fd;
+
+        if (epoll_ctl(m_Epoll, EPOLL_CTL_ADD, fd, &event) < 0)
+        {
+            NotifyError(
+                error::ARGS,
+                std::string("Failed to watch fd ") + std::to_string(fd) + ": " + strerror(errno)
+            );
+
+            return false;
+        }
+
+        m_Sources[fd] = std::move(source);
+
+        return true;
+    }
+
+    void XEventLoop::Unregister(int fd)
+    {
+        epoll_ctl(m_Epoll, EPOLL_CTL_DEL, fd, nullptr);
+        m_Sources.erase(fd);
+    }
+
+    bool XEventLoop::AddWindow(Window& window)
+    {
+        if (!EnsureValid())
+            return false;
+
+        if (std::find(m_Windows.begin(), m_Windows.end(), &window) != m_Windows.end())
+            return true;
+
+        int fd = window.GetEventFd();
+
+        if (fd < 0)
+            return false;
+
+        auto source = std::make_shared<Source>();
+        source->type = SourceType::WINDOW;
+        source->window = &window;
+
+        if (!Register(fd, EPOLLIN, source))
+            return false;
+
+        m_Windows.push_back(&window);
+
+        return true;
+    }
+
+    void XEventLoop::RemoveWindow(Window& window)
+    {
+        auto it = std::find(m_Windows.begin(), m_Windows.end(), &window);
+
+        if (it == m_Windows.end())
+            return;
+
+        m_Windows.erase(it);
+
+        for (auto& source : m_Sources)
+        {
+            if (source.second->window == &window)
+            {
+                Unregister(source.first);
+                break;
+            }
+        }
+    }
+
+    timer_id XEventLoop::AddTimer(
+        std::chrono::nanoseconds delay,
+        timer_callback cb,
+        std::chrono::nanoseconds interval
+    )
+    {
+        if (!EnsureValid())
+            return 0;
+
+        int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+
+        if (fd < 0)
+        {
+            NotifyError(error::GENERIC, "Failed to create a timer!");
+            return 0;
+        }
+
+        // A zero expiration disarms a timerfd.
+        if (delay.count() <= 0)
+            delay = std::chrono::nanoseconds(1);
+
+        itimerspec spec;
+        spec.it_value = ToTimespec(delay);
+        spec.it_interval = ToTimespec(std::max(interval, std::chrono::nanoseconds::zero()));
+
+        timerfd_settime(fd, 0, &spec, nullptr);
+
+        auto source = std::make_shared<Source>();
+        source->type = SourceType::TIMER;
+        source->timer = m_NextTimer++;
+        source->periodic = interval.count() > 0;
+        source->on_timer = std::move(cb);
+
+        if (!Register(fd, EPOLLIN, source))
+        {
+            close(fd);
+            return 0;
+        }
+
+        m_Timers[source->timer] = fd;
+
+        return source->timer;
+    }
+
+    void XEventLoop::CancelTimer(timer_id id)
+    {
+        auto it = m_Timers.find(id);
+
+        if (it == m_Timers.end())
+            return;
+
+        int fd = it->second;
+        m_Timers.erase(it);
+
+        Unregister(fd);
+        close(fd);
+    }
+
+    bool XEventLoop::WatchFd(int fd, FdEvent events, fd_callback cb)
+    {
+        if (!EnsureValid())
+            return false;
+
+        auto existing = m_Sources.find(fd);
+
+        if (existing != m_Sources.end())
+        {
+            if (existing->second->type != SourceType::FD)
+            {
+                NotifyError(error::ARGS, "The fd is already in use by the event loop!");
+                return false;
+            }
+
+            Unregister(fd);
+        }
+
+        uint32_t mask = 0;
+
+        if (events & FdEvent::READABLE)
+            mask |= EPOLLIN;
+        if (events & FdEvent::WRITABLE)
+            mask |= EPOLLOUT;
+
+        auto source = std::make_shared<Source>();
+        source->type = SourceType::FD;
+        source->on_ready = std::move(cb);
+
+        return Register(fd, mask, source);
+    }
+
+    void XEventLoop::UnwatchFd(int fd)
+    {
+        auto it = m_Sources.find(fd);
+
+        if (it != m_Sources.end() && it->second->type == SourceType::FD)
+            Unregister(fd);
+    }
+
+    void XEventLoop::Run()
+    {
+        while (RunOnce(std::chrono::nanoseconds(-1)))
+            ;
+
+        // Allows running the loop again later.
+        m_Stopped.store(false, std::memory_order_relaxed);
+    }
+
+    bool XEventLoop::RunOnce(std::chrono::nanoseconds timeout)
+    {
+        if (!EnsureValid())
+            return false;
+
+        // Events Xlib has already read off the socket (e.g. while
+        // waiting for a reply) won't make the fd readable again,
+        // and our own requests have to reach the server before
+        // we go to sleep waiting for the answer.
+        for (auto window : m_Windows)
+        {
+            window->DispatchPending();
+            window->Flush();
+        }
+
+        if (m_Stopped.load(std::memory_order_relaxed) || WindowsClosed())
+            return false;
+
+        int timeout_ms = -1;
+
+        // Round up so sub-millisecond timeouts still sleep,
+        // timers themselves are precise.
+        if (timeout.count() >= 0)
+            timeout_ms = static_cast<int>(
+                std::min<int64_t>((timeout.count() + 999999) / 1000000, INT_MAX)
+            );
+
+        epoll_event events[AWML_EPOLL_BATCH_SIZE];
+
+        int count = epoll_wait(m_Epoll, events, AWML_EPOLL_BATCH_SIZE, timeout_ms);
+
+        if (count < 0 && errno != EINTR)
+        {
+            NotifyError(error::GENERIC, std::string("epoll_wait failed: ") + strerror(errno));
+            return false;
+        }
+
+        for (int i = 0; i < count; ++i)
+            Dispatch(events[i].data.fd, events[i].events);
+
+        return !m_Stopped.load(std::memory_order_relaxed) && !WindowsClosed();
+    }
+
+    void XEventLoop::Stop()
+    {
+        m_Stopped.store(true, std::memory_order_relaxed);
+
+        uint64_t wake = 1;
+        (void)write(m_WakeFd, &wake, sizeof(wake));
+    }
+
+    void XEventLoop::Dispatch(int fd, uint32_t events)
+    {
+        auto it = m_Sources.find(fd);
+
+        // Removed by an earlier callback of the same batch.
+        if (it == m_Sources.end())
+            return;
+
+        std::shared_ptr<Source> source = it->second;
+
+        switch (source->type)
+        {
+        case SourceType::WAKE:
+        {
+            uint64_t wake;
+            (void)read(fd, &wake, sizeof(wake));
+
+            break;
+        }
+        case SourceType::WINDOW:
+            source->window->DispatchPending();
+
+            break;
+
+        case SourceType::TIMER:
+        {
+            uint64_t expirations;
+
+            if (read(fd, &expirations, sizeof(expirations)) != sizeof(expirations))
+                break;
+
+            // Retired before the callback so it can add a new timer.
+            if (!source->periodic)
+                CancelTimer(source->timer);
+
+            source->on_timer();
+
+            break;
+        }
+        case SourceType::FD:
+        {
+            FdEvent ready = FdEvent::NONE;
+
+            if (events & EPOLLIN)
+                ready = ready | FdEvent::READABLE;
+            if (events & EPOLLOUT)
+                ready = ready | FdEvent::WRITABLE;
+            if (events & (EPOLLHUP | EPOLLERR))
+                ready = ready | FdEvent::HANGUP;
+
+            source->on_ready(fd, ready);
+
+            break;
+        }
+        }
+    }
+
+    bool XEventLoop::WindowsClosed()
+    {
+        if (m_Windows.empty())
+            return false;
+
+        for (auto window : m_Windows)
+        {
+            if (!window->ShouldClose())
+                return false;
+        }
+
+        return true;
+    }
+
+    XEventLoop::~XEventLoop()
+    {
+        for (auto& timer : m_Timers)
+            close(timer.second);
+
+        if (m_WakeFd >= 0)
+            close(m_WakeFd);
+
+        if (m_Epoll >= 0)
+            close(m_Epoll);
+    }
+}
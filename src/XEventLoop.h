@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <AWML/event_loop.h>
+
+namespace awml {
+
+    // The epoll backed EventLoop. Every window, timer (a timerfd)
+    // and watched fd is registered with a single epoll instance.
+    class XEventLoop : public EventLoop
+    {
+    private:
+        enum class SourceType : uint8_t
+        {
+            WAKE   = 0,
+            WINDOW = 1,
+            TIMER  = 2,
+            FD     = 3
+        };
+
+        struct Source
+        {
+            SourceType     type;
+            Window*        window;
+            timer_id       timer;
+            bool           periodic;
+            timer_callback on_timer;
+            fd_callback    on_ready;
+        };
+
+        int m_Epoll;
+        int m_WakeFd;
+
+        // Keyed by fd. Dispatch holds its own reference, so a
+        // source can be removed from inside its own callback.
+        std::unordered_map<int, std::shared_ptr<Source>> m_Sources;
+        std::unordered_map<timer_id, int> m_Timers;
+        std::vector<Window*> m_Windows;
+
+        timer_id m_NextTimer;
+
+        std::atomic<bool> m_Stopped;
+
+        error_callback m_ErrorCB;
+    public:
+        XEventLoop();
+
+        void OnError(error_callback cb) override;
+
+        bool AddWindow(Window& window) override;
+
+        void RemoveWindow(Window& window) override;
+
+        timer_id AddTimer(
+            std::chrono::nanoseconds delay,
+            timer_callback cb,
+            std::chrono::nanoseconds interval
+        ) override;
+
+        void CancelTimer(timer_id id) override;
+
+        bool WatchFd(int fd, FdEvent events, fd_callback cb) override;
+
+        void UnwatchFd(int fd) override;
+
+        void Run() override;
+
+        bool RunOnce(std::chrono::nanoseconds timeout) override;
+
+        void Stop() override;
+
+        ~XEventLoop();
+    private:
+        bool EnsureValid();
+
+        void NotifyError(error code, const std::string& message);
+
+        bool Register(int fd, uint32_t events, std::shared_ptr<Source> source);
+        void Unregister(int fd);
+
+        void Dispatch(int fd, uint32_t events);
+
+        bool WindowsClosed();
+    };
+}
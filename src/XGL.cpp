@@ -6,6 +6,8 @@
 
 
 GLXCREATECONTEXTATTRIBSARBPROC                       awml_glXCreateContextAttribsARB;
+GLXSWAPINTERVALEXTPROC                               awml_glXSwapIntervalEXT;
+GLXSWAPINTERVALMESAPROC                              awml_glXSwapIntervalMESA;
 
 // 1.5
 PFNGLGENQUERIESPROC                                  awml_glGenQueries;
@@ -614,6 +616,8 @@ namespace awml {
     bool glLoader::Init()
     {
         awml_glXCreateContextAttribsARB = (GLXCREATECONTEXTATTRIBSARBPROC) glXGetProcAddressARB((const GLubyte*) "glXCreateContextAttribsARB");
+        awml_glXSwapIntervalEXT         = (GLXSWAPINTERVALEXTPROC)         glXGetProcAddressARB((const GLubyte*) "glXSwapIntervalEXT");
+        awml_glXSwapIntervalMESA        = (GLXSWAPINTERVALMESAPROC)        glXGetProcAddressARB((const GLubyte*) "glXSwapIntervalMESA");
 
         if (!awml_glXCreateContextAttribsARB)
             return false;
@@ -5,6 +5,15 @@ typedef GLXContext(*GLXCREATECONTEXTATTRIBSARBPROC)(Display*, GLXFBConfig, GLXCo
 extern  GLXCREATECONTEXTATTRIBSARBPROC awml_glXCreateContextAttribsARB;
 #define glXCreateContextAttribsARB     awml_glXCreateContextAttribsARB
 
+// Optional, only valid if the driver lists the extension.
+typedef void(*GLXSWAPINTERVALEXTPROC)(Display*, GLXDrawable, int);
+typedef int(*GLXSWAPINTERVALMESAPROC)(unsigned int);
+
+extern  GLXSWAPINTERVALEXTPROC  awml_glXSwapIntervalEXT;
+extern  GLXSWAPINTERVALMESAPROC awml_glXSwapIntervalMESA;
+#define glXSwapIntervalEXT      awml_glXSwapIntervalEXT
+#define glXSwapIntervalMESA     awml_glXSwapIntervalMESA
+
 namespace awml {
     class glLoader
     {
@@ -2,14 +2,46 @@
 #include <clocale>
 #include <cstring>
 #include <stdexcept>
+#include <cerrno>
+
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 
 #include <X11/XKBlib.h>
 
 #include "XWindow.h"
 #include "XGL.h"
+#include "GLContextInfo.h"
+#include "KeyTables.h"
 
 namespace awml {
 
+    // How long the input thread sleeps at most before it
+    // rechecks the Xlib queue, only a guard against a missed
+    // wakeup, and how long it backs off while the event
+    // queue is full.
+    static const timespec s_InputSafetyWakeup = { 0, 100000000 };
+    static const timespec s_InputBacklogRetry = { 0, 500000 };
+
+    static uint64_t MonotonicTime()
+    {
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+
+        return static_cast<uint64_t>(now.tv_sec) * 1000000000ull +
+               static_cast<uint64_t>(now.tv_nsec);
+    }
+
+    static bool HasGLXExtension(Display* display, const char* name)
+    {
+        return HasExtension(glXQueryExtensionsString(display, DefaultScreen(display)), name);
+    }
+
     XOpenGLContext::XOpenGLContext()
         : m_Parent(nullptr),
         m_VisualInfo(),
@@ -17,7 +49,10 @@ namespace awml {
         m_Attribs(),
         m_OpenGLContext(),
         m_WinAttribs(),
-        m_BestFBC()
+        m_BestFBC(),
+        m_SwapControl(SwapControl::NONE),
+        m_SwapEXT(false),
+        m_Fences()
     {
     }
 
@@ -25,19 +60,27 @@ namespace awml {
     {
         m_Parent = static_cast<XWindow*>(self);
 
+        const FramebufferConfig& requested = m_Parent->m_Framebuffer;
+
+        // Minimum sizes, the cost below picks among the matches.
         GLint visual_attribs[] =
         {
-            GLX_X_RENDERABLE,  True,
-            GLX_DRAWABLE_TYPE, GLX_WINDOW_BIT,
-            GLX_RENDER_TYPE,   GLX_RGBA_BIT,
-            GLX_X_VISUAL_TYPE, GLX_TRUE_COLOR,
-            GLX_RED_SIZE,      8,
-            GLX_GREEN_SIZE,    8,
-            GLX_BLUE_SIZE,     8,
-            GLX_ALPHA_SIZE,    8,
-            GLX_DEPTH_SIZE,    24,
-            GLX_STENCIL_SIZE,  8,
-            GLX_DOUBLEBUFFER,  True,
+            GLX_X_RENDERABLE,   True,
+            GLX_DRAWABLE_TYPE,  GLX_WINDOW_BIT,
+            GLX_RENDER_TYPE,    GLX_RGBA_BIT,
+            GLX_X_VISUAL_TYPE,  GLX_TRUE_COLOR,
+            GLX_RED_SIZE,       requested.red_bits,
+            GLX_GREEN_SIZE,     requested.green_bits,
+            GLX_BLUE_SIZE,      requested.blue_bits,
+            GLX_ALPHA_SIZE,     requested.alpha_bits,
+            GLX_DEPTH_SIZE,     requested.depth_bits,
+            GLX_STENCIL_SIZE,   requested.stencil_bits,
+            GLX_DOUBLEBUFFER,   requested.double_buffered,
+            GLX_SAMPLE_BUFFERS, requested.samples ? 1 : 0,
+            GLX_SAMPLES,        requested.samples,
+
+            // Terminates the list early unless sRGB was requested.
+            requested.srgb ? GLX_FRAMEBUFFER_SRGB_CAPABLE_ARB : 0, True,
             None
         };
 
@@ -60,44 +103,43 @@ namespace awml {
                 &fb_count
             );
 
-        if (!fbc)
+        if (!fbc || !fb_count)
         {
-            m_Parent->NotifyError(error::CONTEXT, "Failed to setup OpenGL context");
+            XFree(fbc);
+            m_Parent->NotifyError(error::CONTEXT, "No framebuffer config matches the request!");
             return false;
         }
 
-        int best_fbc       = -1,
-            worst_fbc      = -1,
-            best_num_samp  = -1,
-            worst_num_samp = 999;
+        int best_fbc = -1;
+        FramebufferConfig best;
 
-        int i;
-        for (i = 0; i < fb_count; ++i)
+        for (int i = 0; i < fb_count; ++i)
         {
             XVisualInfo* vi = glXGetVisualFromFBConfig(m_Parent->m_Connection, fbc[i]);
-            if (vi)
-            {
-                int samp_buf, samples;
-                glXGetFBConfigAttrib(m_Parent->m_Connection, fbc[i], GLX_SAMPLE_BUFFERS, &samp_buf);
-                glXGetFBConfigAttrib(m_Parent->m_Connection, fbc[i], GLX_SAMPLES, &samples);
 
-                if (best_fbc < 0 || samp_buf && samples > best_num_samp)
-                {
-                    best_fbc = i;
-                    best_num_samp = samples;
-                }
+            if (!vi)
+                continue;
 
-                if (worst_fbc < 0 || !samp_buf || samples < worst_num_samp)
-                {
-                    worst_fbc = i;
-                    worst_num_samp = samples;
-                }
+            XFree(vi);
+
+            FramebufferConfig config = DescribeFBConfig(fbc[i]);
+
+            if (best_fbc < 0 || FBConfigCost(config, requested) < FBConfigCost(best, requested))
+            {
+                best_fbc = i;
+                best = config;
             }
+        }
 
-            XFree(vi);
+        if (best_fbc < 0)
+        {
+            XFree(fbc);
+            m_Parent->NotifyError(error::CONTEXT, "No framebuffer config matches the request!");
+            return false;
         }
 
         m_BestFBC = fbc[best_fbc];
+        m_Parent->m_Framebuffer = best;
 
         XFree(fbc);
 
@@ -122,6 +164,45 @@ namespace awml {
         return true;
     }
 
+    FramebufferConfig XOpenGLContext::DescribeFBConfig(GLXFBConfig fbc)
+    {
+        auto attrib = [this, fbc](int attribute)
+        {
+            int value = 0;
+            glXGetFBConfigAttrib(m_Parent->m_Connection, fbc, attribute, &value);
+            return value;
+        };
+
+        FramebufferConfig config;
+        config.red_bits        = static_cast<uint8_t>(attrib(GLX_RED_SIZE));
+        config.green_bits      = static_cast<uint8_t>(attrib(GLX_GREEN_SIZE));
+        config.blue_bits       = static_cast<uint8_t>(attrib(GLX_BLUE_SIZE));
+        config.alpha_bits      = static_cast<uint8_t>(attrib(GLX_ALPHA_SIZE));
+        config.depth_bits      = static_cast<uint8_t>(attrib(GLX_DEPTH_SIZE));
+        config.stencil_bits    = static_cast<uint8_t>(attrib(GLX_STENCIL_SIZE));
+        config.samples         = static_cast<uint8_t>(attrib(GLX_SAMPLE_BUFFERS) ? attrib(GLX_SAMPLES) : 0);
+        config.srgb            = attrib(GLX_FRAMEBUFFER_SRGB_CAPABLE_ARB) != 0;
+        config.double_buffered = attrib(GLX_DOUBLEBUFFER) != 0;
+
+        return config;
+    }
+
+    uint64_t XOpenGLContext::FBConfigCost(
+        const FramebufferConfig& config,
+        const FramebufferConfig& requested
+    )
+    {
+        // Samples multiply the fill-rate, so they outweigh everything
+        // else, then an sRGB capability nobody asked for, which can
+        // cost a slower format, then the depth/stencil and color bits
+        // per pixel.
+        uint64_t srgb = config.srgb && !requested.srgb;
+        uint64_t depth_stencil = config.depth_bits + config.stencil_bits;
+        uint64_t color = config.red_bits + config.green_bits + config.blue_bits + config.alpha_bits;
+
+        return (static_cast<uint64_t>(config.samples) << 32) | (srgb << 31) | (depth_stencil << 16) | color;
+    }
+
     XVisualInfo* XOpenGLContext::GetVisualInfo()
     {
         if (!EnsureSetup())
@@ -155,12 +236,13 @@ namespace awml {
         if (!EnsureSetup())
             return false;
 
-        int context_attribs[] =
+        const ContextConfig& requested = m_Parent->m_ContextConfig;
+
+        if (requested.no_error && (requested.debug || requested.robust))
         {
-            GLX_CONTEXT_MAJOR_VERSION_ARB, 1,
-            GLX_CONTEXT_MINOR_VERSION_ARB, 0,
-            None
-        };
+            m_Parent->NotifyError(error::ARGS, "A no-error context can't be a debug or robust context!");
+            return false;
+        }
 
         if (!glLoader::Init())
         {
@@ -168,9 +250,70 @@ namespace awml {
             return false;
         }
 
+        Display* display = m_Parent->m_Connection;
+
+        int context_attribs[16];
+        int count = 0;
+
+        auto attrib = [&context_attribs, &count](int name, int value)
+        {
+            context_attribs[count++] = name;
+            context_attribs[count++] = value;
+        };
+
+        // 1.0 gets the newest version the driver has. Profiles only
+        // exist since 3.2 and a 1.0 core context is rejected, 3.2 gets
+        // the newest there as well.
+        int min_major = 1;
+        int min_minor = 0;
+
+        if (requested.major)
+        {
+            min_major = requested.major;
+            min_minor = requested.minor;
+        }
+        else if (requested.profile != GLProfile::DEFAULT)
+        {
+            min_major = 3;
+            min_minor = 2;
+        }
+
+        attrib(GLX_CONTEXT_MAJOR_VERSION_ARB, min_major);
+        attrib(GLX_CONTEXT_MINOR_VERSION_ARB, min_minor);
+
+        if (requested.profile != GLProfile::DEFAULT &&
+            HasGLXExtension(display, "GLX_ARB_create_context_profile"))
+        {
+            attrib(
+                GLX_CONTEXT_PROFILE_MASK_ARB,
+                requested.profile == GLProfile::CORE ?
+                    GLX_CONTEXT_CORE_PROFILE_BIT_ARB :
+                    GLX_CONTEXT_COMPATIBILITY_PROFILE_BIT_ARB
+            );
+        }
+
+        bool robust = requested.robust &&
+            HasGLXExtension(display, "GLX_ARB_create_context_robustness");
+
+        int flags =
+            (requested.debug              ? GLX_CONTEXT_DEBUG_BIT_ARB              : 0) |
+            (requested.forward_compatible ? GLX_CONTEXT_FORWARD_COMPATIBLE_BIT_ARB : 0) |
+            (robust                       ? GLX_CONTEXT_ROBUST_ACCESS_BIT_ARB      : 0);
+
+        if (flags)
+            attrib(GLX_CONTEXT_FLAGS_ARB, flags);
+
+        if (robust)
+            attrib(GLX_CONTEXT_RESET_NOTIFICATION_STRATEGY_ARB, GLX_LOSE_CONTEXT_ON_RESET_ARB);
+
+        if (requested.no_error && HasGLXExtension(display, "GLX_ARB_create_context_no_error"))
+            attrib(GLX_CONTEXT_OPENGL_NO_ERROR_ARB, True);
+
+        context_attribs[count] = None;
+
         m_OpenGLContext = 
             glXCreateContextAttribsARB(
-                m_Parent->m_Connection,
+                display,
                 m_BestFBC, 0,
                 True,
                 context_attribs
@@ -183,18 +326,29 @@ namespace awml {
         }
 
         glXMakeCurrent(
-            m_Parent->m_Connection,
+            display,
             m_Parent->m_Window,
             m_OpenGLContext
         );
 
-        auto glversion = glGetString(GL_VERSION);
-        char major = glversion[0] - '0';
-        char minor = glversion[2] - '0';
+        int major;
+        int minor;
+        ParseGLVersion(glGetString(GL_VERSION), major, minor);
 
         if (!glLoader::LoadVersion(major, minor))
             return false;
 
+        m_Parent->m_ContextConfig = QueryContextConfig();
+
+        m_SwapEXT = HasGLXExtension(display, "GLX_EXT_swap_control");
+
+        if (m_SwapEXT || HasGLXExtension(display, "GLX_MESA_swap_control"))
+            m_SwapControl = SwapControl::INTERVAL;
+
+        // Negative intervals are only defined for the EXT entry point.
+        if (m_SwapEXT && HasGLXExtension(display, "GLX_EXT_swap_control_tear"))
+            m_SwapControl = m_SwapControl | SwapControl::ADAPTIVE;
+
         return true;
     }
 
@@ -210,6 +364,63 @@ namespace awml {
             m_Parent->m_Connection,
             m_Parent->m_Window
         );
+
+        if (!m_Fences.EndFrame())
+            m_Parent->NotifyError(error::CONTEXT, "Failed to wait for a frame fence!");
+    }
+
+    bool XOpenGLContext::SetSwapInterval(int interval)
+    {
+        if (!m_OpenGLContext)
+        {
+            m_Parent->NotifyError(error::CONTEXT, "Cannot set the swap interval of a null context!");
+            return false;
+        }
+
+        if (!(m_SwapControl & SwapControl::INTERVAL))
+            return false;
+
+        bool exact = true;
+
+        if (interval < 0 && !(m_SwapControl & SwapControl::ADAPTIVE))
+        {
+            interval = -interval;
+            exact = false;
+        }
+
+        if (m_SwapEXT)
+            glXSwapIntervalEXT(m_Parent->m_Connection, m_Parent->m_Window, interval);
+        else if (glXSwapIntervalMESA(static_cast<unsigned int>(interval)) != 0)
+            return false;
+
+        return exact;
+    }
+
+    bool XOpenGLContext::SetMaxFramesInFlight(uint32_t frames)
+    {
+        if (!m_OpenGLContext)
+        {
+            m_Parent->NotifyError(error::CONTEXT, "Cannot limit the frames in flight of a null context!");
+            return false;
+        }
+
+        if (frames && !FrameFences::Supported())
+            return false;
+
+        bool exact = frames <= FrameFences::s_MaxFrames;
+        m_Fences.SetLimit(exact ? frames : static_cast<uint32_t>(FrameFences::s_MaxFrames));
+
+        return exact;
+    }
+
+    std::chrono::nanoseconds XOpenGLContext::GetFrameWaitTime()
+    {
+        return m_Fences.LastWait();
+    }
+
+    SwapControl XOpenGLContext::GetSwapControl()
+    {
+        return m_SwapControl;
     }
 
     bool XOpenGLContext::EnsureSetup()
@@ -235,9 +446,18 @@ namespace awml {
         );
     }
 
+    void XOpenGLContext::ReleaseCurrent()
+    {
+        if (!EnsureSetup() || !m_OpenGLContext)
+            return;
+
+        glXMakeCurrent(m_Parent->m_Connection, None, NULL);
+    }
+
     XOpenGLContext::~XOpenGLContext()
     {
-        if (m_OpenGLContext)
+        // The connection is gone if the window was closed first.
+        if (m_OpenGLContext && m_Parent->m_Connection)
         {
             glXMakeCurrent(
                 m_Parent->m_Connection,
@@ -261,16 +481,58 @@ namespace awml {
         Context context,
         WindowMode window_mode,
         CursorMode cursor_mode,
-        bool resizable
-    ) : m_Title(title),
+        bool resizable,
+        const FramebufferConfig& framebuffer,
+        const ContextConfig& context_config
+    ) : m_Shared(),
+        m_Connection(nullptr),
+        m_Window(0),
+        m_Title(title),
         m_Width(width),
         m_Height(height),
+        m_MouseX(0),
+        m_MouseY(0),
         m_Context(nullptr),
         m_ContextType(context),
+        m_ContextOwner(),
+        m_RenderThread(),
+        m_Framebuffer(framebuffer),
+        m_ContextConfig(context_config),
         m_WindowMode(window_mode),
         m_CursorMode(cursor_mode),
-        m_ShouldClose(false)
+        m_ShouldClose(false),
+        m_DecodedWidth(width),
+        m_DecodedHeight(height),
+        m_UseInputThread(false),
+        m_InputThreadConfig(),
+        m_InputThreadRunning(false),
+        m_InputWakeFd(-1),
+        m_EventsReadyFd(-1),
+        m_InputThreadId(),
+        m_InputErrorLock(),
+        m_InputErrors(),
+        m_InputErrorPending(false),
+        m_Posted(),
+        m_WakeupPending(false),
+        m_WakeupFd(-1),
+        m_EventFd(-1),
+        m_Coalescer(m_Events),
+        m_FrameLimiter(),
+        m_QueueInterest(0),
+        m_QueueSelected(false),
+        m_SelectedInput(NoEventMask),
+        m_KeyStateUsed(false),
+        m_PointerUsed(false),
+        m_WantedEvents(ALL_EVENTS)
     {
+        for (auto& keys : m_KeysDown)
+            keys.store(0, std::memory_order_relaxed);
+
+        memset(m_RepeatCount, 0, sizeof(m_RepeatCount));
+
+        for (auto& key : m_KeyTable)
+            key = awml_key::UNKNOWN;
+
         setlocale(LC_ALL, "en_US.utf8");
     }
 
@@ -285,21 +547,37 @@ namespace awml {
         return true;
     }
 
-    bool XWindow::Launch()
+    bool XWindow::EnableInputThread(const InputThreadConfig& config)
     {
-        m_Connection = XOpenDisplay(NULL);
-        XkbSetDetectableAutoRepeat(m_Connection, true, NULL);
-
-        if (!m_Connection)
+        if (m_Connection)
         {
             NotifyError(
-                error::WINDOW,
-                "Could not establish connection with the X server!"
+                error::GENERIC,
+                "The input thread has to be enabled before launching the window!"
             );
 
             return false;
         }
 
+        m_UseInputThread = true;
+        m_InputThreadConfig = config;
+
+        return true;
+    }
+
+    bool XWindow::Launch()
+    {
+        std::string failure;
+        m_Shared = XConnection::Acquire(failure);
+
+        if (!m_Shared)
+        {
+            NotifyError(error::WINDOW, failure);
+            return false;
+        }
+
+        m_Connection = m_Shared->GetDisplay();
+
         if (m_ContextType == Context::NONE)
         {
             uint32_t screen_num = DefaultScreen(m_Connection);
@@ -348,358 +626,1253 @@ namespace awml {
 
         UpdateWindowTitle();
 
-        XSelectInput(
-            m_Connection,
-            m_Window,
-            KeyPressMask      |
-            ButtonPressMask   |
-            KeyReleaseMask    |
-            ButtonReleaseMask |
-            PointerMotionMask |
-            StructureNotifyMask
-        );
+        LoadKeyTable();
+
+        m_Shared->Register(m_Window, this);
+
+        m_SelectedInput = NoEventMask;
+        UpdateInputMask();
 
         XMapWindow(m_Connection, m_Window);
 
         Atom WM_DELETE_WINDOW = XInternAtom(m_Connection, "WM_DELETE_WINDOW", False);
         XSetWMProtocols(m_Connection, m_Window, &WM_DELETE_WINDOW, 1);
 
-        if (!m_Context->Activate())
+        if (m_Context)
+        {
+            if (!m_Context->Activate())
+                return false;
+
+            // Activate made it current on this thread.
+            m_ContextOwner.Acquire();
+        }
+
+        if (!CreateWakeupFds() || (m_UseInputThread && !StartInputThread()))
             return false;
 
         return true;
     }
 
-    void XWindow::UpdateWindowTitle()
+    bool XWindow::CreateWakeupFds()
     {
-        size_t title_size = m_Title.size() * 2;
-        char* title = static_cast<char*>(alloca(title_size));
-        auto final_size = wcstombs(title, m_Title.data(), title_size);
-        if (final_size == SIZE_MAX)
+        m_WakeupFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        m_EventFd  = epoll_create1(EPOLL_CLOEXEC);
+
+        if (m_WakeupFd < 0 || m_EventFd < 0)
         {
-            NotifyError(
-                error::GENERIC,
-                "Failed to convert the window title to UTF-8, title will not be set."
-            );
-            return;
+            NotifyError(error::GENERIC, "Failed to create the wakeup eventfd!");
+            return false;
         }
-        title[final_size] = '\0';
 
-        XStoreName(m_Connection, m_Window, title);
+        epoll_event connection = {};
+        connection.events = EPOLLIN;
+        connection.data.fd = ConnectionNumber(m_Connection);
 
-        Atom _net_wm_name = XInternAtom(m_Connection, "_NET_WM_NAME", false);
-        Atom utf8_string = XInternAtom(m_Connection, "UTF8_STRING", false);
-        XChangeProperty(
-            m_Connection,
-            m_Window,
-            _net_wm_name,
-            utf8_string,
-            8, PropModeReplace,
-            reinterpret_cast<unsigned char*>(title),
-            title_size
-        );
+        epoll_event wakeup = {};
+        wakeup.events = EPOLLIN;
+        wakeup.data.fd = m_WakeupFd;
+
+        if (epoll_ctl(m_EventFd, EPOLL_CTL_ADD, connection.data.fd, &connection) ||
+            epoll_ctl(m_EventFd, EPOLL_CTL_ADD, m_WakeupFd, &wakeup))
+        {
+            NotifyError(error::GENERIC, "Failed to set up the window event fd!");
+            return false;
+        }
+
+        return true;
     }
 
-    void XWindow::NotifyError(error code, const std::string& message)
+    bool XWindow::SwapEventFdSource(int from, int to)
     {
-        if (m_ErrorCB)
-            m_ErrorCB(code, message);
-        else
-            // TODO: Replace with an awml specific error class
-            throw std::runtime_error(message);
+        if (m_EventFd < 0)
+            return false;
+
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.fd = to;
+
+        epoll_ctl(m_EventFd, EPOLL_CTL_DEL, from, nullptr);
+
+        return !epoll_ctl(m_EventFd, EPOLL_CTL_ADD, to, &event);
     }
 
-    bool XWindow::SetContext(window_context wc) 
+    void XWindow::CloseWakeupFds()
     {
-        // Dynamically switching contexts is currently
-        // not supported. Hopefully later?
-        // m_Context.reset(wc.release());
+        if (m_WakeupFd >= 0)
+            close(m_WakeupFd);
 
-        
+        if (m_EventFd >= 0)
+            close(m_EventFd);
 
-        return true;
+        m_WakeupFd = -1;
+        m_EventFd  = -1;
     }
 
-    void XWindow::PollEvents()
+    bool XWindow::StartInputThread()
     {
-        XPending(m_Connection);
+        m_InputWakeFd   = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        m_EventsReadyFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
 
-        while (XQLength(m_Connection))
+        if (m_InputWakeFd < 0 || m_EventsReadyFd < 0)
         {
-            XNextEvent(m_Connection, &m_Event);
-
-            switch (m_Event.type)
-            {
-            case ConfigureNotify:
-
-                if (m_Event.xconfigure.width == m_Width &&
-                    m_Event.xconfigure.height == m_Height)
-                    return;
+            NotifyError(error::GENERIC, "Failed to create the input thread eventfds!");
+            return false;
+        }
 
-                m_Width = m_Event.xconfigure.width;
-                m_Height = m_Event.xconfigure.height;
+        // The thread takes over the connection, the event fd
+        // watches its notifications instead but stays the same.
+        if (!SwapEventFdSource(ConnectionNumber(m_Connection), m_EventsReadyFd))
+        {
+            NotifyError(error::GENERIC, "Failed to set up the window event fd!");
+            return false;
+        }
 
-                if (m_WindowResizedCB)
-                    m_WindowResizedCB(m_Width, m_Height);
+        m_InputThreadRunning.store(true, std::memory_order_release);
+        m_InputThread = std::thread(&XWindow::InputThreadMain, this);
 
-                break;
+        auto handle = m_InputThread.native_handle();
 
-            case ButtonPress:
-            {
-                auto button = m_Event.xbutton.button;
+        if (m_InputThreadConfig.priority > 0)
+        {
+            sched_param param = {};
+            param.sched_priority = m_InputThreadConfig.priority;
+
+            if (pthread_setschedparam(handle, SCHED_FIFO, &param))
+                NotifyError(
+                    error::GENERIC,
+                    "Failed to set the input thread priority, running with the default one."
+                );
+        }
 
-                if (button == 4 || button == 5)
-                {
-                    if (m_MouseScrolledCB)
-                        m_MouseScrolledCB(
-                            button == 4 ? 10 : -10, true
-                        );
-                    break;
-                }
-                else if (button == 6 || button == 7)
-                {
-                    if (m_MouseScrolledCB)
-                        m_MouseScrolledCB(button == 6 ? 10 : -10, false);
-                    break;
-                }
-                else if (m_MousePressedCB)
-                    m_MousePressedCB(
-                        static_cast<awml_key>(button)
-                    );
+        if (m_InputThreadConfig.cpu_affinity)
+        {
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
 
-                break;
-            }
-            case ButtonRelease:
+            for (int cpu = 0; cpu < 64 && cpu < CPU_SETSIZE; ++cpu)
             {
-                auto button = m_Event.xbutton.button;
-
-                if (button == 4 ||
-                    button == 5 ||
-                    button == 6 ||
-                    button == 7
-                    )
-                    break;
-
-                if (m_MouseReleasedCB)
-                    m_MouseReleasedCB(
-                        static_cast<awml_key>(button)
-                    );
-
-                break;
+                if (m_InputThreadConfig.cpu_affinity & (1ull << cpu))
+                    CPU_SET(cpu, &cpus);
             }
-            case KeyPress:
-            {
-                wchar_t typed_char = GetTypedChar();
 
-                if (typed_char && m_CharTypedCB)
-                    m_CharTypedCB(
-                        typed_char
-                    );
+            if (pthread_setaffinity_np(handle, sizeof(cpus), &cpus))
+                NotifyError(
+                    error::GENERIC,
+                    "Failed to set the input thread CPU affinity."
+                );
+        }
 
-                auto key = NormalizeKeyPress();
+        return true;
+    }
 
-                if (m_KeyPressedCB)
-                    m_KeyPressedCB(
-                        key,
-                        GetKeyRepeatCount(key),
-                        GetKeyRepeatCount(key)
-                    );
+    void XWindow::StopInputThread()
+    {
+        if (m_InputThread.joinable())
+        {
+            m_InputThreadRunning.store(false, std::memory_order_release);
 
-                IncremetRepeatCount(key);
+            uint64_t wake = 1;
+            (void)write(m_InputWakeFd, &wake, sizeof(wake));
 
-                break;
-            }
-            case KeyRelease:
-            {
-                auto key = NormalizeKeyPress();
+            m_InputThread.join();
+        }
 
-                if (m_KeyReleasedCB)
-                    m_KeyReleasedCB(key);
+        if (m_InputWakeFd >= 0)
+            close(m_InputWakeFd);
 
-                ResetRepeatCount(key);
+        if (m_EventsReadyFd >= 0)
+        {
+            SwapEventFdSource(m_EventsReadyFd, ConnectionNumber(m_Connection));
+            close(m_EventsReadyFd);
+        }
 
-                break;
-            }
-            case MotionNotify:
-                if (m_MouseMovedCB)
-                    m_MouseMovedCB(
-                        m_Event.xmotion.x,
-                        m_Event.xmotion.y
-                    );
+        m_InputWakeFd   = -1;
+        m_EventsReadyFd = -1;
+    }
 
-                break;
+    void XWindow::InputThreadMain()
+    {
+        m_InputThreadId.store(std::this_thread::get_id(), std::memory_order_relaxed);
 
-            case ClientMessage:
-                m_ShouldClose = true;
+        // Nothing may escape the thread, an exception
+        // ends it and the consumer takes over polling.
+        try
+        {
+            InputThreadLoop();
+        }
+        catch (const std::exception& e)
+        {
+            NotifyError(error::GENERIC, e.what());
+        }
+        catch (...)
+        {
+            NotifyError(error::GENERIC, "The input thread failed!");
+        }
 
-                break;
+        // Ids are reused, errors of a later thread are its own.
+        m_InputThreadId.store(std::thread::id(), std::memory_order_relaxed);
 
-            default:
-                break;
-            }
+        if (m_InputThreadRunning.exchange(false, std::memory_order_acq_rel))
+        {
+            uint64_t ready = 1;
+            (void)write(m_EventsReadyFd, &ready, sizeof(ready));
         }
     }
 
-    void XWindow::SwapBuffers()
+    void XWindow::ReportInputErrors()
     {
-        if (m_Context)
-            m_Context->SwapBuffers();
-    }
+        if (m_InputThread.joinable() && !m_InputThreadRunning.load(std::memory_order_acquire))
+            StopInputThread();
 
-    void XWindow::MakeCurrent()
-    {
-        if (!EnsureAlive())
+        if (!m_InputErrorPending.exchange(false, std::memory_order_acquire))
             return;
 
-        if (m_Context)
-            m_Context->MakeCurrent();
-        else
-            NotifyError(error::CONTEXT, "Cannot make NULL context current!");
-    }
+        std::vector<std::pair<error, std::string>> errors;
 
-    void XWindow::Update() 
-    {
-        PollEvents();
-        SwapBuffers();
-    }
+        {
+            std::lock_guard<std::mutex> lock(m_InputErrorLock);
+            errors.swap(m_InputErrors);
+        }
 
-    void XWindow::SetTitle(const std::wstring& title)
-    {
-        m_Title = title;
-        UpdateWindowTitle();
+        for (const auto& entry : errors)
+            NotifyError(entry.first, entry.second);
     }
 
-    bool XWindow::ShouldClose()
+    void XWindow::InputThreadLoop()
     {
-        return m_ShouldClose;
-    }
-
-    void XWindow::Close()
+        pollfd fds[2] =
+        {
+            { ConnectionNumber(m_Connection), POLLIN, 0 },
+            { m_InputWakeFd,                  POLLIN, 0 }
+        };
+
+        bool woken = false;
+
+        while (m_InputThreadRunning.load(std::memory_order_acquire))
+        {
+            XLockDisplay(m_Connection);
+
+            // Events for the other windows are routed
+            // to them and they're notified by the pump.
+            XEventsQueued(m_Connection, QueuedAfterReading);
+            bool backlog = PumpConnection();
+
+            XUnlockDisplay(m_Connection);
+
+            // A Wakeup is passed on even if nothing was posted.
+            if (!m_Events.Empty() || woken)
+            {
+                uint64_t ready = 1;
+                (void)write(m_EventsReadyFd, &ready, sizeof(ready));
+            }
+
+            // Replies to requests made on other threads can drag events
+            // into the Xlib queue without the socket becoming readable
+            // for us. SwapBuffers wakes us for those, the timeout only
+            // guards against the ones nobody noticed. A backlog means
+            // the queue was full, give the consumer a moment.
+            ppoll(
+                fds, 2,
+                backlog ? &s_InputBacklogRetry : &s_InputSafetyWakeup,
+                nullptr
+            );
+
+            woken = fds[1].revents & POLLIN;
+
+            if (woken)
+            {
+                uint64_t wake;
+                (void)read(m_InputWakeFd, &wake, sizeof(wake));
+            }
+        }
+    }
+
+    void XWindow::UpdateWindowTitle()
     {
-        static bool closed = false;
+        size_t title_size = m_Title.size() * 2;
+        char* title = static_cast<char*>(alloca(title_size));
+        auto final_size = wcstombs(title, m_Title.data(), title_size);
+        if (final_size == SIZE_MAX)
+        {
+            NotifyError(
+                error::GENERIC,
+                "Failed to convert the window title to UTF-8, title will not be set."
+            );
+            return;
+        }
+        title[final_size] = '\0';
 
-        // TODO: Change internal state
-        // to prevent using the window
-        // after manually calling close.
-        if (!closed)
+        XStoreName(m_Connection, m_Window, title);
+
+        Atom _net_wm_name = XInternAtom(m_Connection, "_NET_WM_NAME", false);
+        Atom utf8_string = XInternAtom(m_Connection, "UTF8_STRING", false);
+        XChangeProperty(
+            m_Connection,
+            m_Window,
+            _net_wm_name,
+            utf8_string,
+            8, PropModeReplace,
+            reinterpret_cast<unsigned char*>(title),
+            title_size
+        );
+    }
+
+    void XWindow::NotifyError(error code, const std::string& message)
+    {
+        // Neither thrown nor called back on the input thread.
+        if (m_InputThreadId.load(std::memory_order_relaxed) == std::this_thread::get_id())
         {
-            XCloseDisplay(m_Connection);
-            closed = true;
+            {
+                std::lock_guard<std::mutex> lock(m_InputErrorLock);
+                m_InputErrors.emplace_back(code, message);
+            }
+
+            m_InputErrorPending.store(true, std::memory_order_release);
+
+            // Ends a consumer's wait to report it.
+            uint64_t ready = 1;
+            (void)write(m_EventsReadyFd, &ready, sizeof(ready));
+
+            return;
         }
+
+        EventWindow::NotifyError(code, message);
     }
 
-    uint16_t XWindow::GetWidth()
+    bool XWindow::SetContext(window_context wc) 
     {
-        return m_Width;
+        // Dynamically switching contexts is currently
+        // not supported. Hopefully later?
+        // m_Context.reset(wc.release());
+
+        
+
+        return true;
     }
 
-    uint16_t XWindow::GetHeight()
+    bool XWindow::BeginPoll()
     {
-        return m_Height;
+        ReportInputErrors();
+
+        // With the input thread running the
+        // connection belongs to it, only consume.
+        if (!m_InputThread.joinable())
+            XPending(m_Connection);
+
+        return true;
     }
 
-    uint16_t XWindow::GetMouseX()
+    size_t XWindow::DrainEvents(Event* out, size_t max)
     {
-        return m_MouseX;
+        // Draining without a SelectEvents takes everything.
+        if (!m_QueueSelected)
+            SelectEvents(ALL_EVENTS);
+
+        return EventWindow::DrainEvents(out, max);
+    }
+
+    int XWindow::GetEventFd()
+    {
+        if (!EnsureAlive())
+            return -1;
+
+        return m_EventFd;
     }
 
-    uint16_t XWindow::GetMouseY()
+    bool XWindow::BeginDispatch()
     {
-        return m_MouseY;
+        if (!EnsureAlive())
+            return false;
+
+        ReportInputErrors();
+
+        if (m_InputThread.joinable())
+        {
+            // Rearm the notification before consuming, anything
+            // queued after this point signals the fd again.
+            uint64_t ready;
+            (void)read(m_EventsReadyFd, &ready, sizeof(ready));
+        }
+        else
+        {
+            uint64_t wake;
+            (void)read(m_WakeupFd, &wake, sizeof(wake));
+
+            // Moves whatever is sitting in the socket into
+            // the Xlib queue, unlike XPending this never flushes.
+            XEventsQueued(m_Connection, QueuedAfterReading);
+        }
+
+        return true;
     }
 
-    std::pair<uint16_t, uint16_t> XWindow::GetMouseCoords()
+    void XWindow::Flush()
     {
-        return { m_MouseX, m_MouseY };
+        if (m_Connection)
+            XFlush(m_Connection);
     }
 
-    void XWindow::OnError(
-        error_callback cb
-    )
+    void XWindow::ApplyWindowState(const Event& event)
+    {
+        switch (event.type)
+        {
+        case EventType::WINDOW_RESIZED:
+            m_Width = event.size.width;
+            m_Height = event.size.height;
+            break;
+        case EventType::MOUSE_MOVED:
+            m_MouseX = event.mouse.x;
+            m_MouseY = event.mouse.y;
+            break;
+        default:
+            break;
+        }
+    }
+
+    void XWindow::WaitEvents()
+    {
+        if (!EnsureAlive())
+            return;
+
+        WaitForEvents(nullptr);
+        PollEvents();
+    }
+
+    void XWindow::WaitEventsTimeout(std::chrono::nanoseconds timeout)
+    {
+        if (!EnsureAlive())
+            return;
+
+        if (timeout.count() < 0)
+            timeout = std::chrono::nanoseconds::zero();
+
+        auto seconds = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+
+        timespec ts;
+        ts.tv_sec  = static_cast<time_t>(seconds.count());
+        ts.tv_nsec = static_cast<long>((timeout - seconds).count());
+
+        WaitForEvents(&ts);
+        PollEvents();
+    }
+
+    bool XWindow::WaitForEvents(const timespec* timeout)
+    {
+        timespec deadline;
+
+        if (timeout)
+        {
+            clock_gettime(CLOCK_MONOTONIC, &deadline);
+            deadline.tv_sec  += timeout->tv_sec;
+            deadline.tv_nsec += timeout->tv_nsec;
+
+            if (deadline.tv_nsec >= 1000000000L)
+            {
+                deadline.tv_sec  += 1;
+                deadline.tv_nsec -= 1000000000L;
+            }
+        }
+
+        ReportInputErrors();
+
+        bool threaded = m_InputThread.joinable();
+
+        // With the input thread running we wait for it to
+        // signal decoded events rather than on the connection.
+        pollfd fds[2] =
+        {
+            { threaded ? m_EventsReadyFd : ConnectionNumber(m_Connection), POLLIN, 0 },
+            { threaded ? -1 : m_WakeupFd,                                  POLLIN, 0 }
+        };
+
+        for (;;)
+        {
+            if (m_WakeupPending.exchange(false, std::memory_order_acquire))
+            {
+                uint64_t wake;
+                (void)read(threaded ? m_EventsReadyFd : m_WakeupFd, &wake, sizeof(wake));
+
+                return true;
+            }
+
+            if (threaded)
+            {
+                uint64_t ready;
+                (void)read(m_EventsReadyFd, &ready, sizeof(ready));
+
+                // Errors are reported by the poll after the wait.
+                if (!m_Events.Empty() || m_InputErrorPending.load(std::memory_order_acquire))
+                    return true;
+            }
+            else
+            {
+                // XPending flushes our requests and picks up anything
+                // that's already sitting in the socket, which may as
+                // well belong to the other windows.
+                if (XPending(m_Connection))
+                    PumpConnection();
+
+                if (!m_Events.Empty())
+                    return true;
+            }
+
+            timespec remaining;
+
+            if (timeout)
+            {
+                timespec now;
+                clock_gettime(CLOCK_MONOTONIC, &now);
+
+                remaining.tv_sec  = deadline.tv_sec  - now.tv_sec;
+                remaining.tv_nsec = deadline.tv_nsec - now.tv_nsec;
+
+                if (remaining.tv_nsec < 0)
+                {
+                    remaining.tv_sec  -= 1;
+                    remaining.tv_nsec += 1000000000L;
+                }
+
+                if (remaining.tv_sec < 0)
+                    return false;
+            }
+
+            int result = ppoll(fds, 2, timeout ? &remaining : nullptr, nullptr);
+
+            if (result < 0 && errno != EINTR)
+            {
+                NotifyError(error::WINDOW, "Failed to wait for events on the X connection!");
+                return false;
+            }
+
+            // Also signalled by other windows' pumps without a pending
+            // Wakeup, left readable it would end every later wait at once.
+            if (fds[1].revents & POLLIN)
+            {
+                uint64_t wake;
+                (void)read(m_WakeupFd, &wake, sizeof(wake));
+            }
+
+            if (result == 0)
+            {
+                if (!threaded && XPending(m_Connection))
+                    PumpConnection();
+
+                return !m_Events.Empty();
+            }
+        }
+    }
+
+    bool XWindow::PumpEvents()
+    {
+        return !m_InputThread.joinable() && PumpConnection();
+    }
+
+    size_t XWindow::PendingEvents()
+    {
+        if (m_InputThread.joinable())
+            return 0;
+
+        return XQLength(m_Connection) + m_Shared->HeldEvents(this);
+    }
+
+    bool XWindow::PumpConnection()
+    {
+        // Posted events are staged under the display lock as
+        // well, other windows' pumps may be routing to us.
+        XLockDisplay(m_Connection);
+
+        Event posted;
+
+        while (m_Events.Space() > EventCoalescer::s_MaxHeld && m_Posted.Pop(posted))
+            Emit(posted);
+
+        bool more = m_Shared->Pump(this);
+
+        m_Coalescer.Flush();
+
+        XUnlockDisplay(m_Connection);
+
+        return more;
+    }
+
+    bool XWindow::CanDecode()
     {
-        m_ErrorCB = cb;
+        // A single X event can decode into two awml events
+        // (key press + typed char), and the coalescer might
+        // be holding back a couple more.
+        return m_Events.Space() >= 2 + EventCoalescer::s_MaxHeld;
+    }
+
+    void XWindow::FinishPump(bool foreign)
+    {
+        m_Coalescer.Flush();
+
+        uint64_t ready = 1;
+
+        // Events decoded by another window's pump would otherwise
+        // sit in the queue unnoticed by whoever waits on our fd.
+        if (m_EventsReadyFd >= 0)
+            (void)write(m_EventsReadyFd, &ready, sizeof(ready));
+        else if (foreign && m_WakeupFd >= 0)
+            (void)write(m_WakeupFd, &ready, sizeof(ready));
+    }
+
+    void XWindow::DecodeEvent(const XEvent& xevent)
+    {
+        Event event;
+        event.timestamp = MonotonicTime();
+        event.count = 1;
+
+        switch (xevent.type)
+        {
+        case ConfigureNotify:
+
+            if (xevent.xconfigure.width == m_DecodedWidth &&
+                xevent.xconfigure.height == m_DecodedHeight)
+                break;
+
+            m_DecodedWidth = xevent.xconfigure.width;
+            m_DecodedHeight = xevent.xconfigure.height;
+
+            event.type = EventType::WINDOW_RESIZED;
+            event.size = { m_DecodedWidth, m_DecodedHeight };
+            Emit(event);
+
+            break;
+
+        case ButtonPress:
+        {
+            auto button = xevent.xbutton.button;
+
+            if (button == 4 || button == 5)
+            {
+                event.type = EventType::MOUSE_SCROLLED;
+                event.scroll = { static_cast<int16_t>(button == 4 ? 10 : -10), true };
+            }
+            else if (button == 6 || button == 7)
+            {
+                event.type = EventType::MOUSE_SCROLLED;
+                event.scroll = { static_cast<int16_t>(button == 6 ? 10 : -10), false };
+            }
+            else
+            {
+                auto key = button < 10 ? s_XButtons[button] : awml_key::UNKNOWN;
+
+                event.type = EventType::MOUSE_PRESSED;
+                event.button = { key };
+
+                SetKeyDown(key, true);
+            }
+
+            Emit(event);
+
+            break;
+        }
+        case ButtonRelease:
+        {
+            auto button = xevent.xbutton.button;
+
+            if (button == 4 ||
+                button == 5 ||
+                button == 6 ||
+                button == 7
+                )
+                break;
+
+            auto key = button < 10 ? s_XButtons[button] : awml_key::UNKNOWN;
+
+            event.type = EventType::MOUSE_RELEASED;
+            event.button = { key };
+            Emit(event);
+
+            SetKeyDown(key, false);
+
+            break;
+        }
+        case KeyPress:
+        {
+            wchar_t typed_char = GetTypedChar();
+
+            if (typed_char)
+            {
+                event.type = EventType::CHAR_TYPED;
+                event.text = { typed_char };
+                Emit(event);
+            }
+
+            auto keycode = static_cast<uint8_t>(xevent.xkey.keycode);
+            auto key = m_KeyTable[keycode];
+            auto repeat_count = m_RepeatCount[keycode];
+
+            event.type = EventType::KEY_PRESSED;
+            event.key = { key, repeat_count, repeat_count != 0 };
+            Emit(event);
+
+            if (repeat_count != UINT8_MAX)
+                m_RepeatCount[keycode]++;
+
+            SetKeyDown(key, true);
+
+            break;
+        }
+        case KeyRelease:
+        {
+            auto keycode = static_cast<uint8_t>(xevent.xkey.keycode);
+            auto key = m_KeyTable[keycode];
+
+            event.type = EventType::KEY_RELEASED;
+            event.key = { key, 0, false };
+            Emit(event);
+
+            m_RepeatCount[keycode] = 0;
+            SetKeyDown(key, false);
+
+            break;
+        }
+        case KeymapNotify:
+            // Sent right after we gain focus, carries the
+            // full key state so no round trip is needed.
+            LoadKeymap(xevent.xkeymap.key_vector);
+
+            break;
+
+        case FocusOut:
+            // Releases that happen while unfocused never reach us.
+            LoadKeymap(nullptr);
+
+            break;
+
+        case MotionNotify:
+            event.type = EventType::MOUSE_MOVED;
+            event.mouse = {
+                static_cast<uint16_t>(xevent.xmotion.x),
+                static_cast<uint16_t>(xevent.xmotion.y)
+            };
+            Emit(event);
+
+            break;
+
+        case ClientMessage:
+            m_ShouldClose.store(true, std::memory_order_relaxed);
+
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    void XWindow::SwapBuffers()
+    {
+        if (m_Context)
+            m_Context->SwapBuffers();
+
+        // Replies read by the swap may have queued events behind
+        // the input thread's back, the socket won't tell it.
+        if (m_InputWakeFd >= 0 && XQLength(m_Connection))
+        {
+            uint64_t wake = 1;
+            (void)write(m_InputWakeFd, &wake, sizeof(wake));
+        }
+
+        m_Awaiters.EndFrame();
+    }
+
+    bool XWindow::SetSwapInterval(int interval)
+    {
+        if (!m_Context)
+        {
+            NotifyError(error::CONTEXT, "The window has no graphics context!");
+            return false;
+        }
+
+        return m_Context->SetSwapInterval(interval);
+    }
+
+    SwapControl XWindow::GetSwapControl()
+    {
+        return m_Context ? m_Context->GetSwapControl() : SwapControl::NONE;
+    }
+
+    bool XWindow::SetMaxFramesInFlight(uint32_t frames)
+    {
+        if (!m_Context)
+        {
+            NotifyError(error::CONTEXT, "The window has no graphics context!");
+            return false;
+        }
+
+        return m_Context->SetMaxFramesInFlight(frames);
+    }
+
+    std::chrono::nanoseconds XWindow::GetFrameWaitTime()
+    {
+        return m_Context ? m_Context->GetFrameWaitTime() : std::chrono::nanoseconds::zero();
+    }
+
+    void XWindow::SetTargetFrameRate(double hz)
+    {
+        m_FrameLimiter.SetRate(hz);
+    }
+
+    FramePacingStats XWindow::GetFramePacingStats()
+    {
+        return m_FrameLimiter.Stats();
+    }
+
+    void XWindow::MakeCurrent()
+    {
+        if (!EnsureAlive())
+            return;
+
+        if (!m_Context)
+        {
+            NotifyError(error::CONTEXT, "Cannot make NULL context current!");
+            return;
+        }
+
+        if (!m_ContextOwner.Acquire())
+        {
+            NotifyError(
+                error::CONTEXT,
+                "The context is current on another thread, release it there first!"
+            );
+
+            return;
+        }
+
+        m_Context->MakeCurrent();
+    }
+
+    void XWindow::ReleaseCurrent()
+    {
+        if (!m_Context || !m_ContextOwner.IsOwner())
+            return;
+
+        m_Context->ReleaseCurrent();
+        m_ContextOwner.Release();
+    }
+
+    bool XWindow::StartRenderThread(render_callback render)
+    {
+        if (!EnsureAlive())
+            return false;
+
+        if (!m_Context)
+        {
+            NotifyError(error::CONTEXT, "A render thread needs a graphics context!");
+            return false;
+        }
+
+        if (m_RenderThread.Running())
+        {
+            NotifyError(error::GENERIC, "The render thread is already running!");
+            return false;
+        }
+
+        // Handed over from the calling thread.
+        ReleaseCurrent();
+        if (!m_RenderThread.Start(*this, m_ContextOwner, render))
+        {
+            // Reported on the render thread if there was a callback.
+            if (!m_RenderThread.Error().empty())
+                NotifyError(error::CONTEXT, m_RenderThread.Error());
+
+            return false;
+        }
+
+        return true;
+    }
+
+    void XWindow::StopRenderThread()
+    {
+        m_RenderThread.Stop();
+    }
+
+    void XWindow::Update() 
+    {
+        m_FrameLimiter.Wait();
+
+        PollEvents();
+        SwapBuffers();
+    }
+
+    void XWindow::SetTitle(const std::wstring& title)
+    {
+        m_Title = title;
+        UpdateWindowTitle();
+    }
+
+    void XWindow::Close()
+    {
+        // TODO: Change internal state
+        // to prevent using the window
+        // after manually calling close.
+        StopRenderThread();
+        StopInputThread();
+        CloseWakeupFds();
+        StopRecording();
+
+        if (m_Shared && m_Window)
+        {
+            m_Shared->Unregister(m_Window);
+
+            XDestroyWindow(m_Connection, m_Window);
+            XFlush(m_Connection);
+        }
+
+        m_Window = 0;
+
+        // The connection closes with its last window.
+        m_Shared.reset();
+        m_Connection = nullptr;
     }
 
     void XWindow::OnKeyPressed(
         key_pressed_callback cb
     )
     {
-        m_KeyPressedCB = cb;
+        m_Callbacks.key_pressed = cb;
+        UpdateInputMask();
     }
 
     void XWindow::OnKeyReleased(
         key_released_callback cb
     )
     {
-        m_KeyReleasedCB = cb;
+        m_Callbacks.key_released = cb;
+        UpdateInputMask();
     }
 
     void XWindow::OnWindowResized(
         window_resized_callback cb
     )
     {
-        m_WindowResizedCB = cb;
+        m_Callbacks.window_resized = cb;
+        UpdateInputMask();
     }
 
     void XWindow::OnWindowClosed(
         window_closed_callback cb
     )
     {
-        m_WindowClosedCB = cb;
+        m_Callbacks.window_closed = cb;
+        UpdateInputMask();
     }
 
     void XWindow::OnMouseMoved(
         mouse_moved_callback cb
     )
     {
-        m_MouseMovedCB = cb;
+        m_Callbacks.mouse_moved = cb;
+        UpdateInputMask();
     }
 
     void XWindow::OnMousePressed(
         mouse_pressed_callback cb
     )
     {
-        m_MousePressedCB = cb;
+        m_Callbacks.mouse_pressed = cb;
+        UpdateInputMask();
     }
 
     void XWindow::OnMouseReleased(
         mouse_released_callback cb
     )
     {
-       m_MouseReleasedCB = cb;
+        m_Callbacks.mouse_released = cb;
+        UpdateInputMask();
     }
 
     void XWindow::OnMouseScrolled(
         mouse_scrolled_callback cb
     )
     {
-       m_MouseScrolledCB = cb;
+        m_Callbacks.mouse_scrolled = cb;
+        UpdateInputMask();
     }
 
     void XWindow::OnCharTyped(
         char_typed_callback cb
     )
     {
-        m_CharTypedCB = cb;
+        m_Callbacks.char_typed = cb;
+        UpdateInputMask();
+    }
+
+    void XWindow::OnUserEvent(
+        user_event_callback cb
+    )
+    {
+        m_Callbacks.user_event = cb;
+        UpdateInputMask();
     }
 
-    bool XWindow::Minimized()
+    void XWindow::SetCallbackExecutor(
+        EventType type,
+        callback_executor executor
+    )
     {
-        return m_Width == 0 && m_Height == 0;
+        if (!m_Callbacks.SetExecutor(type, executor))
+            NotifyError(error::ARGS, "There is no callback for this event type!");
+    }
+
+    bool XWindow::PostEvent(const UserEvent& user)
+    {
+        Event event;
+        event.type = EventType::USER;
+        event.count = 1;
+        event.timestamp = MonotonicTime();
+        event.user = user;
+
+        if (!m_Posted.Push(event))
+            return false;
+
+        Wakeup();
+
+        return true;
+    }
+
+    void XWindow::Wakeup()
+    {
+        m_WakeupPending.store(true, std::memory_order_release);
+
+        uint64_t wake = 1;
+
+        if (m_InputWakeFd >= 0)
+            (void)write(m_InputWakeFd, &wake, sizeof(wake));
+        else if (m_WakeupFd >= 0)
+            (void)write(m_WakeupFd, &wake, sizeof(wake));
+    }
+
+    void XWindow::Emit(const Event& event)
+    {
+        if (m_WantedEvents.load(std::memory_order_relaxed) & EventBit(event.type))
+            m_Coalescer.Stage(event);
+    }
+
+    void XWindow::SetKeyDown(awml_key key, bool down)
+    {
+        auto index = static_cast<size_t>(key);
+        uint64_t bit = 1ull << (index % 64);
+
+        if (down)
+            m_KeysDown[index / 64].fetch_or(bit, std::memory_order_relaxed);
+        else
+            m_KeysDown[index / 64].fetch_and(~bit, std::memory_order_relaxed);
+    }
+
+    void XWindow::LoadKeymap(const char* key_vector)
+    {
+        // key_vector is the 32 byte keycode bitmap X uses
+        // in KeymapNotify and XQueryKeymap, null clears.
+        uint64_t keys[(AWML_KEY_COUNT + 63) / 64] = {};
+
+        if (key_vector)
+        {
+            for (size_t keycode = 0; keycode < 256; ++keycode)
+            {
+                if (!(key_vector[keycode / 8] & (1 << (keycode % 8))))
+                    continue;
+
+                auto index = static_cast<size_t>(m_KeyTable[keycode]);
+                keys[index / 64] |= 1ull << (index % 64);
+            }
+        }
+
+        // Not a key, just where the unmapped keycodes end up.
+        keys[0] &= ~1ull;
+
+        for (size_t word = 0; word < (AWML_KEY_COUNT + 63) / 64; ++word)
+            m_KeysDown[word].store(keys[word], std::memory_order_relaxed);
+
+        memset(m_RepeatCount, 0, sizeof(m_RepeatCount));
+    }
+
+    void XWindow::LoadKeyTable()
+    {
+        int min_keycode;
+        int max_keycode;
+
+        XDisplayKeycodes(m_Connection, &min_keycode, &max_keycode);
+
+        for (auto& key : m_KeyTable)
+            key = awml_key::UNKNOWN;
+
+        // Resolves every keycode once so decoding a key event
+        // is a single table load instead of a keysym lookup.
+        for (int keycode = min_keycode; keycode <= max_keycode && keycode < 256; ++keycode)
+        {
+            for (int level = 0; level < 2; ++level)
+            {
+                auto key_sym = XkbKeycodeToKeysym(m_Connection, keycode, 0, level);
+
+                KeySym lower_sym;
+                KeySym upper_sym;
+
+                XConvertCase(key_sym, &lower_sym, &upper_sym);
+
+                for (const auto& mapping : s_XKeySyms)
+                {
+                    if (mapping.native == lower_sym)
+                    {
+                        m_KeyTable[keycode] = mapping.key;
+                        break;
+                    }
+                }
+
+                if (m_KeyTable[keycode] != awml_key::UNKNOWN)
+                    break;
+            }
+        }
+    }
+
+    void XWindow::SelectEvents(event_mask mask)
+    {
+        m_QueueInterest = mask;
+        m_QueueSelected = true;
+        UpdateInputMask();
+    }
+
+    void XWindow::UpdateInputMask()
+    {
+        // IsKeyPressed and GetMouse* can get here from any thread.
+        if (m_Connection)
+            XLockDisplay(m_Connection);
+
+        // Resizes always go through to keep the window size up to date.
+        event_mask wanted =
+            m_Callbacks.Mask() |
+            m_QueueInterest    |
+            m_Awaiters.Mask()  |
+            (m_TrackInput ? InputTracker::Mask() : 0) |
+            (m_PointerUsed.load(std::memory_order_relaxed) ? EventBit(EventType::MOUSE_MOVED) : 0) |
+            EventBit(EventType::WINDOW_RESIZED);
+
+        m_WantedEvents.store(wanted, std::memory_order_relaxed);
+
+        long input = InputMaskFor(wanted, m_KeyStateUsed.load(std::memory_order_relaxed));
+
+        if (input != m_SelectedInput)
+        {
+            m_SelectedInput = input;
+
+            if (m_Connection && m_Window)
+                XSelectInput(m_Connection, m_Window, input);
+        }
+
+        if (m_Connection)
+            XUnlockDisplay(m_Connection);
+    }
+
+    long XWindow::InputMaskFor(event_mask wanted, bool key_state)
+    {
+        // Focus changes and the key state sent after them keep
+        // the key table right across focus changes, cheap enough
+        // to always take.
+        long input = FocusChangeMask | KeymapStateMask;
+
+        if (wanted & EventBit(EventType::WINDOW_RESIZED))
+            input |= StructureNotifyMask;
+
+        // Presses need the releases for the repeat counts.
+        event_mask keys =
+            EventBit(EventType::KEY_PRESSED)  |
+            EventBit(EventType::KEY_RELEASED) |
+            EventBit(EventType::CHAR_TYPED);
+
+        if (key_state || (wanted & keys))
+            input |= KeyPressMask | KeyReleaseMask;
+
+        // The scroll wheel is reported as button presses.
+        event_mask buttons =
+            EventBit(EventType::MOUSE_PRESSED)  |
+            EventBit(EventType::MOUSE_RELEASED) |
+            EventBit(EventType::MOUSE_SCROLLED);
+
+        if (key_state || (wanted & buttons))
+            input |= ButtonPressMask | ButtonReleaseMask;
+
+        if (wanted & EventBit(EventType::MOUSE_MOVED))
+            input |= PointerMotionMask;
+
+        return input;
+    }
+
+    void XWindow::TrackKeyState()
+    {
+        UpdateInputMask();
+
+        if (!m_Connection)
+            return;
+
+        // Keys already down when the key events were selected
+        // would be missed, start from the server's state once.
+        char keys[32];
+
+        XLockDisplay(m_Connection);
+        XQueryKeymap(m_Connection, keys);
+        LoadKeymap(keys);
+        XUnlockDisplay(m_Connection);
+    }
+
+    void XWindow::TrackPointer()
+    {
+        // Only the first caller selects the motion events.
+        if (!m_PointerUsed.exchange(true, std::memory_order_relaxed))
+            UpdateInputMask();
+    }
+
+    bool XWindow::StartRecording(const std::string& path)
+    {
+        if (!m_Recorder.Start(path, m_Width, m_Height))
+        {
+            NotifyError(error::GENERIC, "Failed to create the event log!");
+            return false;
+        }
+
+        return true;
+    }
+
+    void XWindow::StopRecording()
+    {
+        m_Recorder.Stop();
+    }
+
+    void XWindow::SetEventCoalescing(Coalesce mode)
+    {
+        m_Coalescer.SetMode(mode);
     }
 
     bool XWindow::IsKeyPressed(awml_key key_code)
     {
-        char key_map[32];
+        auto index = static_cast<size_t>(key_code);
 
-        auto xcode = XKeysymToKeycode(
-            m_Connection,
-            static_cast<KeySym>(key_code)
-        );
+        if (key_code == awml_key::UNKNOWN || index >= AWML_KEY_COUNT)
+            return false;
 
-        XQueryKeymap(m_Connection, key_map);
+        if (!m_KeyStateUsed.load(std::memory_order_relaxed) &&
+            !m_KeyStateUsed.exchange(true, std::memory_order_relaxed))
+            TrackKeyState();
 
-        return key_map[xcode/8] & (0x1<<(xcode%8));
+        return m_KeysDown[index / 64].load(std::memory_order_relaxed) &
+               (1ull << (index % 64));
+    }
+
+    const InputSnapshot& XWindow::BeginFrame()
+    {
+        if (!m_TrackInput)
+        {
+            m_TrackInput = true;
+            UpdateInputMask();
+        }
+
+        KeySet down;
+
+        for (size_t word = 0; word < KeySet::s_Words; ++word)
+            down.bits[word] = m_KeysDown[word].load(std::memory_order_relaxed);
+
+        return m_Input.Publish(down);
     }
 
     void XWindow::SetCursorMode(CursorMode cursor_mode)
@@ -717,37 +1890,23 @@ namespace awml {
 
     }
 
-    void* XWindow::GetNativeHandle()
+    const FramebufferConfig& XWindow::GetFramebufferConfig()
     {
-        return m_Connection;
+        return m_Framebuffer;
     }
 
-    awml_key XWindow::NormalizeKeyPress()
+    const ContextConfig& XWindow::GetContextConfig()
     {
-        auto key_sym = XkbKeycodeToKeysym(
-            m_Connection,
-            m_Event.xkey.keycode,
-            0,
-            m_Event.xkey.state & ShiftMask ? 1 : 0
-        );
-
-        KeySym lower_sym;
-        KeySym upper_sym;
-
-        XConvertCase(key_sym, &lower_sym, &upper_sym);
+        return m_ContextConfig;
+    }
 
-        return static_cast<awml_key>(lower_sym);
+    void* XWindow::GetNativeHandle()
+    {
+        return m_Connection;
     }
 
     wchar_t XWindow::GetTypedChar()
     {
-        auto key_sym = XkbKeycodeToKeysym(
-            m_Connection,
-            m_Event.xkey.keycode,
-            0,
-            m_Event.xkey.state & ShiftMask ? 1 : 0
-        );
-
         // This is not how you actually get the typed char
         // To be fixed later. (its like 2k lines to get this working btw)
         //static_cast<wchar_t>(*XKeysymToString(key_sym))
@@ -755,32 +1914,34 @@ namespace awml {
         return static_cast<wchar_t>(0);
     }
 
-    uint8_t XWindow::GetKeyRepeatCount(awml_key code)
+    void XWindow::Suspend(AwaitNode& node)
     {
-        return m_RepeatCount.count(code) ?
-            m_RepeatCount[code] : 0;
+        // Only the first wait for a kind of event changes the mask.
+        if (m_Awaiters.Push(node))
+            UpdateInputMask();
     }
 
-    void XWindow::IncremetRepeatCount(awml_key code)
+    void* XWindow::AllocateCoroutine(size_t size)
     {
-        if (m_RepeatCount.count(code))
-        {
-            if (m_RepeatCount[code] != UINT8_MAX)
-                m_RepeatCount[code]++;
-        }
-        else
-            m_RepeatCount[code] = 1;
+        return m_Awaiters.Arena().Allocate(size);
     }
 
-    void XWindow::ResetRepeatCount(awml_key code)
+    void XWindow::FreeCoroutine(void* frame, size_t size)
     {
-        if (m_RepeatCount.count(code))
-            m_RepeatCount[code] = 0;
+        m_Awaiters.Arena().Free(frame, size);
     }
 
     XWindow::~XWindow()
     {
-        if (!m_Context)
-            Close();
+        StopRenderThread();
+        m_Awaiters.DestroySuspended();
+        StopInputThread();
+        CloseWakeupFds();
+
+        // The context closes the window as it goes, which has to
+        // happen while the members Close touches are still alive.
+        m_Context.reset();
+
+        Close();
     }
 }
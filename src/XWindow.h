@@ -1,6 +1,11 @@
 #pragma once
 
-#include <unordered_map>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include <X11/Xlib.h>
 #include <X11/Xutil.h>
@@ -10,6 +15,15 @@
 #include <AWML/key_codes.h>
 #include <AWML/awml.h>
 
+#include "EventCoalescer.h"
+#include "EventWindow.h"
+#include "MPSCQueue.h"
+#include "FrameFences.h"
+#include "FrameLimiter.h"
+#include "XConnection.h"
+#include "RenderThread.h"
+#include "utilities.h"
+
 namespace awml {
 
     class XWindow;
@@ -24,30 +38,54 @@ namespace awml {
         GLXContext           m_OpenGLContext;
         XWindowAttributes    m_WinAttribs;
         GLXFBConfig          m_BestFBC;
+
+        // Found by Activate, EXT is preferred over MESA.
+        SwapControl m_SwapControl;
+        bool        m_SwapEXT;
+
+        FrameFences m_Fences;
     public:
         XOpenGLContext();
 
         bool Setup(Window* self) override;
         bool Activate() override;
         void MakeCurrent() override;
+        void ReleaseCurrent() override;
         void SwapBuffers() override;
 
+        bool SetSwapInterval(int interval) override;
+        SwapControl GetSwapControl() override;
+
+        bool SetMaxFramesInFlight(uint32_t frames) override;
+        std::chrono::nanoseconds GetFrameWaitTime() override;
+
         XVisualInfo* GetVisualInfo();
         XSetWindowAttributes* GetAttribsPtr();
 
         ~XOpenGLContext();
     private:
         bool EnsureSetup();
+
+        FramebufferConfig DescribeFBConfig(GLXFBConfig fbc);
+
+        // Lower is cheaper to render to.
+        static uint64_t FBConfigCost(
+            const FramebufferConfig& config,
+            const FramebufferConfig& requested
+        );
     };
 
-    class XWindow : public Window
+    class XWindow final : public EventWindow
     {
     private:
         friend class XOpenGLContext;
+        friend class XConnection;
     private:
+        // Shared by all windows, m_Connection is its display.
+        std::shared_ptr<XConnection> m_Shared;
+
         Display* m_Connection;
         ::Window m_Window;
-        XEvent m_Event;
 
         std::wstring m_Title;
 
@@ -60,24 +98,77 @@ namespace awml {
         Context m_ContextType;
         window_context m_Context;
 
+        ContextOwner m_ContextOwner;
+        RenderThread m_RenderThread;
+
+        // Requested, then chosen by XOpenGLContext::Setup.
+        FramebufferConfig m_Framebuffer;
+
+        // Requested, then read back by XOpenGLContext::Activate.
+        ContextConfig m_ContextConfig;
+
         WindowMode m_WindowMode;
         CursorMode m_CursorMode;
 
-        bool m_ShouldClose;
-
-        std::unordered_map<awml_key, uint8_t>
-            m_RepeatCount;
-
-        error_callback          m_ErrorCB;
-        key_pressed_callback    m_KeyPressedCB;
-        key_released_callback   m_KeyReleasedCB;
-        window_resized_callback m_WindowResizedCB;
-        window_closed_callback  m_WindowClosedCB;
-        mouse_moved_callback    m_MouseMovedCB;
-        mouse_pressed_callback  m_MousePressedCB;
-        mouse_released_callback m_MouseReleasedCB;
-        mouse_scrolled_callback m_MouseScrolledCB;
-        char_typed_callback     m_CharTypedCB;
+        std::atomic<bool> m_ShouldClose;
+
+        // Size as last seen by the decoder, m_Width/m_Height
+        // follow once the resize event is consumed.
+        uint16_t m_DecodedWidth;
+        uint16_t m_DecodedHeight;
+
+        bool              m_UseInputThread;
+        InputThreadConfig m_InputThreadConfig;
+        std::thread       m_InputThread;
+        std::atomic<bool> m_InputThreadRunning;
+        int               m_InputWakeFd;
+        int               m_EventsReadyFd;
+
+        // Errors raised on the input thread, reported to
+        // the consumer by its next poll or wait instead.
+        std::atomic<std::thread::id>                 m_InputThreadId;
+        std::mutex                                   m_InputErrorLock;
+        std::vector<std::pair<error, std::string>>   m_InputErrors;
+        std::atomic<bool>                            m_InputErrorPending;
+
+        // Events posted from other threads, moved into the event
+        // queue by whoever decodes. Without the input thread the
+        // wakeups go through m_WakeupFd, which is polled together
+        // with the connection through m_EventFd. With it, m_EventFd
+        // watches the thread's m_EventsReadyFd instead.
+        MPSCQueue<Event, AWML_USER_EVENT_QUEUE_SIZE> m_Posted;
+        std::atomic<bool> m_WakeupPending;
+        int               m_WakeupFd;
+        int               m_EventFd;
+
+        // Key and mouse button state indexed by awml_key, maintained
+        // by the decoder from the event stream. The pressed bits are
+        // read from any thread, the repeat counts (by X keycode) are
+        // decoder only.
+        std::atomic<uint64_t> m_KeysDown[(AWML_KEY_COUNT + 63) / 64];
+        uint8_t               m_RepeatCount[256];
+
+        // X keycode -> awml_key, built on Launch and rebuilt
+        // whenever the keyboard mapping changes. Decoder only.
+        awml_key m_KeyTable[256];
+
+        EventCoalescer m_Coalescer;
+
+        FrameLimiter m_FrameLimiter;
+
+        // Stays empty until the queue is consumed, so
+        // a callback only app never selects what it ignores.
+        event_mask m_QueueInterest;
+        bool       m_QueueSelected;
+        long       m_SelectedInput;
+
+        // Set by the first IsKeyPressed and GetMouse* calls,
+        // which need the key and pointer events from then on.
+        std::atomic<bool> m_KeyStateUsed;
+        std::atomic<bool> m_PointerUsed;
+
+        // Event types that have a consumer, read by the decoder.
+        std::atomic<event_mask> m_WantedEvents;
     public:
         XWindow(
             const std::wstring& title,
@@ -86,18 +177,37 @@ namespace awml {
             Context context,
             WindowMode window_mode,
             CursorMode cursor_mode,
-            bool resizable
+            bool resizable,
+            const FramebufferConfig& framebuffer = FramebufferConfig(),
+            const ContextConfig& context_config = ContextConfig()
         );
 
         bool Launch() override;
 
+        bool EnableInputThread(const InputThreadConfig& config) override;
+
         bool SetContext(window_context wc) override;
 
-        void PollEvents() override;
+        size_t DrainEvents(Event* out, size_t max) override;
+        int GetEventFd() override;
+
+        void Flush() override;
+
+        void WaitEvents() override;
+        void WaitEventsTimeout(std::chrono::nanoseconds timeout) override;
         void SwapBuffers() override;
 
         void Update() override;
 
+        bool SetSwapInterval(int interval) override;
+        SwapControl GetSwapControl() override;
+
+        void SetTargetFrameRate(double hz) override;
+        FramePacingStats GetFramePacingStats() override;
+
+        bool SetMaxFramesInFlight(uint32_t frames) override;
+        std::chrono::nanoseconds GetFrameWaitTime() override;
+
         void SetTitle(const std::wstring& title) override;
 
         bool ShouldClose() override;
@@ -111,10 +221,6 @@ namespace awml {
         uint16_t GetMouseY() override;
         std::pair<uint16_t, uint16_t> GetMouseCoords() override;
 
-        void OnError(
-            error_callback cb
-        ) override;
-
         void OnKeyPressed(
             key_pressed_callback cb
         ) override;
@@ -151,10 +257,36 @@ namespace awml {
             char_typed_callback cb
         ) override;
 
+        void OnUserEvent(
+            user_event_callback cb
+        ) override;
+
+        void SetCallbackExecutor(
+            EventType type,
+            callback_executor executor
+        ) override;
+
+        bool PostEvent(const UserEvent& event) override;
+
+        void Wakeup() override;
+
+        void SetEventCoalescing(Coalesce mode) override;
+
+        void SelectEvents(event_mask mask) override;
+
+        bool StartRecording(const std::string& path) override;
+
+        void StopRecording() override;
+
         bool Minimized() override;
 
         bool IsKeyPressed(awml_key key_code) override;
 
+        // The X event mask selected on the window.
+        long GetSelectedInput() const { return m_SelectedInput; }
+
+        const InputSnapshot& BeginFrame() override;
+
         void SetCursorMode(CursorMode cursor_mode) override;
 
         void SetWindowMode(WindowMode window_mode) override;
@@ -163,23 +295,120 @@ namespace awml {
 
         void* GetNativeHandle() override;
 
+        const FramebufferConfig& GetFramebufferConfig() override;
+
+        const ContextConfig& GetContextConfig() override;
+
         void MakeCurrent() override;
 
+        void ReleaseCurrent() override;
+
+        bool StartRenderThread(render_callback render) override;
+
+        void StopRenderThread() override;
+
+        void Suspend(AwaitNode& node) override;
+
+        void* AllocateCoroutine(size_t size) override;
+        void FreeCoroutine(void* frame, size_t size) override;
+
         ~XWindow();
     private:
         bool EnsureAlive();
 
-        void NotifyError(error code, const std::string& message);
+        void NotifyError(error code, const std::string& message) override;
 
         void UpdateWindowTitle();
 
-        awml_key NormalizeKeyPress();
+        void UpdateInputMask();
+
+        // The X events needed for the wanted event types.
+        static long InputMaskFor(event_mask wanted, bool key_state);
+
+        void TrackKeyState();
+        void TrackPointer();
+
+        bool BeginPoll() override;
+        bool BeginDispatch() override;
+        bool PumpEvents() override;
+        size_t PendingEvents() override;
+        void ApplyWindowState(const Event& event) override;
+
+        // Decodes what the connection has for the window, on whichever
+        // thread owns it. True if more is waiting behind a full queue.
+        bool PumpConnection();
+        bool WaitForEvents(const timespec* timeout);
+
+        bool CreateWakeupFds();
+        void CloseWakeupFds();
+
+        // Replaces the fd m_EventFd watches.
+        bool SwapEventFdSource(int from, int to);
+
+        bool StartInputThread();
+        void StopInputThread();
+        void InputThreadMain();
+        void InputThreadLoop();
+
+        // Falls back to polling on the calling thread
+        // if the input thread died with the error.
+        void ReportInputErrors();
+        // Called by XConnection::Pump for the events of this window.
+        bool CanDecode();
+        void DecodeEvent(const XEvent& xevent);
+        void FinishPump(bool foreign);
+
+        void LoadKeyTable();
 
         wchar_t GetTypedChar();
 
-        uint8_t GetKeyRepeatCount(awml_key code);
+        void Emit(const Event& event);
 
-        void IncremetRepeatCount(awml_key code);
-        void ResetRepeatCount(awml_key code);
+        void SetKeyDown(awml_key key, bool down);
+        void LoadKeymap(const char* key_vector);
     };
+
+    inline bool XWindow::ShouldClose()
+    {
+        return m_ShouldClose.load(std::memory_order_relaxed);
+    }
+
+    inline uint16_t XWindow::GetWidth()
+    {
+        return m_Width;
+    }
+
+    inline uint16_t XWindow::GetHeight()
+    {
+        return m_Height;
+    }
+
+    inline uint16_t XWindow::GetMouseX()
+    {
+        if (!m_PointerUsed.load(std::memory_order_relaxed))
+            TrackPointer();
+
+        return m_MouseX;
+    }
+
+    inline uint16_t XWindow::GetMouseY()
+    {
+        if (!m_PointerUsed.load(std::memory_order_relaxed))
+            TrackPointer();
+
+        return m_MouseY;
+    }
+
+    inline std::pair<uint16_t, uint16_t> XWindow::GetMouseCoords()
+    {
+        if (!m_PointerUsed.load(std::memory_order_relaxed))
+            TrackPointer();
+
+        return { m_MouseX, m_MouseY };
+    }
+
+    inline bool XWindow::Minimized()
+    {
+        return m_Width == 0 && m_Height == 0;
+    }
 }
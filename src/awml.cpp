@@ -1,14 +1,25 @@
 #ifdef _WIN32
     #include "WindowsWindow.h"
+    #include "WindowsEventLoop.h"
     #define AWML_NATIVE_WINDOW WindowsWindow
+    #define AWML_NATIVE_EVENT_LOOP WindowsEventLoop
 #elif defined(__linux__)
     #include "XWindow.h"
+    #include "XEventLoop.h"
     #define AWML_NATIVE_WINDOW XWindow
+    #define AWML_NATIVE_EVENT_LOOP XEventLoop
 #else
     #error Sorry, your platform is currently not supported!
     #define AWML_NATIVE_WINDOW
+    #define AWML_NATIVE_EVENT_LOOP
 #endif
 
+#include <cstdlib>
+#include <cstring>
+
+#include "NullWindow.h"
+#include "ReplayWindow.h"
+
 namespace awml {
 
     Window::SharedWindow Window::Create(
@@ -18,9 +29,36 @@ namespace awml {
         Context context,
         WindowMode window_mode,
         CursorMode cursor_mode,
-        bool resizable
+        bool resizable,
+        WindowBackend backend,
+        const FramebufferConfig& framebuffer,
+        const ContextConfig& context_config
     )
     {
+        if (backend == WindowBackend::DEFAULT)
+        {
+            // Lets CI and benchmarks go headless without code changes.
+            const char* selected = std::getenv("AWML_BACKEND");
+
+            backend = selected && !strcmp(selected, "headless") ?
+                WindowBackend::HEADLESS :
+                WindowBackend::NATIVE;
+        }
+
+        if (backend == WindowBackend::HEADLESS)
+            return
+                std::make_shared<NullWindow>(
+                    title,
+                    width,
+                    height,
+                    context,
+                    window_mode,
+                    cursor_mode,
+                    resizable,
+                    framebuffer,
+                    context_config
+                );
+
         return
             std::make_shared<AWML_NATIVE_WINDOW>(
                 title,
@@ -29,7 +67,22 @@ namespace awml {
                 context,
                 window_mode,
                 cursor_mode,
-                resizable
+                resizable,
+                framebuffer,
+                context_config
             );
     }
+
+    Window::SharedWindow Window::CreateReplay(
+        const std::string& log_path,
+        ReplaySpeed speed
+    )
+    {
+        return std::make_shared<ReplayWindow>(log_path, speed);
+    }
+
+    EventLoop::UniqueEventLoop EventLoop::Create()
+    {
+        return std::make_unique<AWML_NATIVE_EVENT_LOOP>();
+    }
 }
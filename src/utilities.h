@@ -1,6 +1,10 @@
 #pragma once
 
 #include <cstddef>
+#include <stdexcept>
+#include <string>
+
+#include <AWML/awml.h>
 
 #if _MSVC_LANG > 201703L || __cplusplus > 201703L
     #define AWML_LIKELY   [[likely]]
@@ -12,8 +16,30 @@
 
 #ifdef _WIN32
     #define AWML_REPEATED_BIT      0x40000000
+    #define AWML_EXTENDED_KEY_BIT  0x01000000
+    #define AWML_SCAN_CODE_SHIFT   16
     #define AWML_KEY_PRESSED_BIT   0x8000
     #define AWML_REPEAT_COUNT_MASK 0xffff
     #define AWML_MOUSE_X1_BIT      0x0001
     #define AWML_MOUSE_X2_BIT      0x0002
 #endif
+
+// Capacity of the per-window decoded event queue,
+// has to be a power of two.
+#define AWML_EVENT_QUEUE_SIZE 1024
+
+// Capacity of the per-window queue of posted user
+// events, has to be a power of two.
+#define AWML_USER_EVENT_QUEUE_SIZE 256
+
+namespace awml {
+
+    // Hands an error to cb, or throws it if nobody listens.
+    inline void ReportError(const error_callback& cb, error code, const std::string& message)
+    {
+        if (cb)
+            cb(code, message);
+        else
+            throw std::runtime_error(message);
+    }
+}
@@ -0,0 +1,28 @@
+#include "check.h"
+
+#include <AWML/basic_window.h>
+#include <AWML/headless.h>
+
+using namespace awml;
+
+int main()
+{
+    HeadlessWindow window(L"Test", 640, 480);
+    CHECK(window.Launch());
+
+    HeadlessControl* control = GetHeadlessControl(window.AsWindow());
+    CHECK(control);
+
+    Event event = {};
+    event.type = EventType::WINDOW_RESIZED;
+    event.size = { 800, 600 };
+
+    CHECK(control->InjectEvent(event));
+
+    window.Update();
+
+    CHECK(window.GetWidth() == 800);
+    CHECK(window.GetHeight() == 600);
+
+    return 0;
+}
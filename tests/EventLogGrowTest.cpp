@@ -0,0 +1,71 @@
+#include "check.h"
+
+#include <csignal>
+#include <cstdio>
+
+#include <sys/resource.h>
+
+#include <AWML/awml.h>
+#include <AWML/headless.h>
+
+#include <EventLog.h>
+
+using namespace awml;
+
+int main()
+{
+    const char* path = "EventLogGrowTest.log";
+
+    // The log starts with room for 4096 events,
+    // the file size limit lets it grow no further.
+    const uint64_t fits = 4096;
+
+    signal(SIGXFSZ, SIG_IGN);
+
+    rlimit limit;
+    getrlimit(RLIMIT_FSIZE, &limit);
+    limit.rlim_cur = sizeof(EventLogHeader) + fits * sizeof(Event) + 1;
+    CHECK(!setrlimit(RLIMIT_FSIZE, &limit));
+
+    {
+        auto window = Window::Create(
+            L"Test", 640, 480,
+            Context::NONE,
+            WindowMode::WINDOWED,
+            CursorMode::VISIBLE | CursorMode::FREE,
+            false,
+            WindowBackend::HEADLESS
+        );
+
+        int errors = 0;
+        window->OnError([&errors](error code, const std::string&) { errors += code == error::GENERIC; });
+
+        CHECK(window->Launch());
+        CHECK(window->StartRecording(path));
+
+        HeadlessControl* control = GetHeadlessControl(*window);
+
+        Event event = {};
+        event.type = EventType::KEY_PRESSED;
+        event.key = { awml_key::A, 0, false };
+
+        for (uint64_t sent = 0; sent < fits + 100;)
+        {
+            while (sent < fits + 100 && control->InjectEvent(event))
+                ++sent;
+
+            window->PollEvents();
+        }
+
+        // Reported once, the recording stops with it.
+        CHECK(errors == 1);
+    }
+
+    EventLogReader log;
+    CHECK(log.Open(path).empty());
+    CHECK(log.Count() == fits);
+
+    std::remove(path);
+
+    return 0;
+}
@@ -0,0 +1,64 @@
+#include "check.h"
+
+#include <cstdio>
+
+#include <AWML/awml.h>
+#include <AWML/headless.h>
+
+using namespace awml;
+
+int main()
+{
+    const char* path = "EventLogTest.log";
+
+    {
+        auto window = Window::Create(
+            L"Test", 640, 480,
+            Context::NONE,
+            WindowMode::WINDOWED,
+            CursorMode::VISIBLE | CursorMode::FREE,
+            false,
+            WindowBackend::HEADLESS
+        );
+
+        CHECK(window->Launch());
+        CHECK(window->StartRecording(path));
+
+        int local = 0;
+        int users = 0;
+        window->OnUserEvent([&users](uint32_t, void*) { ++users; });
+
+        CHECK(window->PostEvent(UserEvent { 1, &local }));
+
+        Event event = {};
+        event.type = EventType::KEY_PRESSED;
+        event.key = { awml_key::A, 0, false };
+
+        CHECK(GetHeadlessControl(*window)->InjectEvent(event));
+
+        window->PollEvents();
+        CHECK(users == 1);
+
+        window->StopRecording();
+    }
+
+    auto replay = Window::CreateReplay(path, ReplaySpeed::AS_FAST_AS_POSSIBLE);
+    CHECK(replay->Launch());
+
+    // The user event's data pointed into the recording run.
+    int users = 0;
+    int pressed = 0;
+    replay->OnUserEvent([&users](uint32_t, void*) { ++users; });
+    replay->OnKeyPressed([&pressed](awml_key key, bool, uint16_t) { pressed += key == awml_key::A; });
+
+    while (!replay->ShouldClose())
+        replay->PollEvents();
+
+    CHECK(users == 0);
+    CHECK(pressed == 1);
+
+    replay.reset();
+    std::remove(path);
+
+    return 0;
+}
@@ -0,0 +1,44 @@
+#include "check.h"
+
+#include <AWML/awml.h>
+#include <AWML/headless.h>
+
+using namespace awml;
+
+int main()
+{
+    auto window = Window::Create(
+        L"Test", 640, 480,
+        Context::NONE,
+        WindowMode::WINDOWED,
+        CursorMode::VISIBLE | CursorMode::FREE,
+        false,
+        WindowBackend::HEADLESS
+    );
+
+    CHECK(window->Launch());
+
+    HeadlessControl* control = GetHeadlessControl(*window);
+    CHECK(control);
+
+    control->SetTime(1000);
+    control->AdvanceTime(std::chrono::nanoseconds(500));
+    CHECK(control->GetTime() == 1500);
+
+    int pressed = 0;
+    window->OnKeyPressed([&pressed](awml_key key, bool, uint16_t) { pressed += key == awml_key::A; });
+
+    Event event = {};
+    event.type = EventType::KEY_PRESSED;
+    event.key = { awml_key::A, 0, false };
+
+    CHECK(control->InjectEvent(event));
+
+    window->Update();
+
+    CHECK(pressed == 1);
+    CHECK(window->IsKeyPressed(awml_key::A));
+    CHECK(control->GetFrameCount() == 1);
+
+    return 0;
+}
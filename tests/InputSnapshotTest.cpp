@@ -0,0 +1,63 @@
+#include "check.h"
+
+#include <atomic>
+#include <thread>
+
+#include <AWML/awml.h>
+#include <AWML/headless.h>
+
+using namespace awml;
+
+int main()
+{
+    auto window = Window::Create(
+        L"Test", 640, 480,
+        Context::NONE,
+        WindowMode::WINDOWED,
+        CursorMode::VISIBLE | CursorMode::FREE,
+        false,
+        WindowBackend::HEADLESS
+    );
+
+    CHECK(window->Launch());
+
+    HeadlessControl* control = GetHeadlessControl(*window);
+
+    std::atomic<bool> done(false);
+    std::atomic<bool> torn(false);
+
+    // Every frame moves the mouse to its own number, a torn
+    // copy mixes the fields of two frames.
+    std::thread reader([&]()
+    {
+        while (!done.load(std::memory_order_relaxed))
+        {
+            InputSnapshot snapshot = window->ReadInputSnapshot();
+
+            if (snapshot.frame &&
+                (snapshot.mouse_x != (snapshot.frame - 1) % 1000 ||
+                 snapshot.mouse_y != snapshot.mouse_x))
+                torn.store(true, std::memory_order_relaxed);
+        }
+    });
+
+    for (uint16_t i = 0; i < 20000; ++i)
+    {
+        Event event = {};
+        event.type = EventType::MOUSE_MOVED;
+        event.mouse = { static_cast<uint16_t>(i % 1000), static_cast<uint16_t>(i % 1000) };
+
+        CHECK(control->InjectEvent(event));
+
+        window->PollEvents();
+        window->BeginFrame();
+    }
+
+    done.store(true, std::memory_order_relaxed);
+    reader.join();
+
+    CHECK(!torn.load());
+    CHECK(window->ReadInputSnapshot().frame == 20000);
+
+    return 0;
+}
@@ -0,0 +1,122 @@
+#include "check.h"
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+#include <AWML/awml.h>
+
+using namespace awml;
+
+static Window::SharedWindow CreateWindow()
+{
+    auto window = Window::Create(
+        L"Test", 640, 480,
+        Context::OpenGL,
+        WindowMode::WINDOWED,
+        CursorMode::VISIBLE | CursorMode::FREE,
+        false,
+        WindowBackend::HEADLESS
+    );
+
+    CHECK(window->Launch());
+
+    return window;
+}
+
+// Takes the context over on another thread and keeps it
+// current there until done is set.
+static std::thread HoldContext(Window& window, std::atomic<bool>& held, std::atomic<bool>& done)
+{
+    return std::thread(
+        [&window, &held, &done]()
+        {
+            window.MakeCurrent();
+            held.store(true);
+
+            while (!done.load())
+                std::this_thread::yield();
+
+            window.ReleaseCurrent();
+        }
+    );
+}
+
+int main()
+{
+    {
+        auto window = CreateWindow();
+        std::atomic<int> frames(0);
+
+        CHECK(window->StartRenderThread([&frames]() { ++frames; }));
+
+        while (frames.load() < 10)
+            std::this_thread::yield();
+
+        window->StopRenderThread();
+    }
+
+    // Without an error callback the failure is thrown on the
+    // calling thread, not inside the render thread.
+    {
+        auto window = CreateWindow();
+        window->ReleaseCurrent();
+
+        std::atomic<bool> held(false);
+        std::atomic<bool> done(false);
+        std::thread holder = HoldContext(*window, held, done);
+
+        while (!held.load())
+            std::this_thread::yield();
+
+        bool threw = false;
+
+        try
+        {
+            window->StartRenderThread([]() {});
+        }
+        catch (const std::runtime_error&)
+        {
+            threw = true;
+        }
+
+        CHECK(threw);
+
+        done.store(true);
+        holder.join();
+
+        // Released by the holder, the handoff works again.
+        std::atomic<int> frames(0);
+        CHECK(window->StartRenderThread([&frames]() { ++frames; }));
+
+        while (frames.load() < 1)
+            std::this_thread::yield();
+
+        window->StopRenderThread();
+    }
+
+    // With one the callback is told and Start returns false.
+    {
+        auto window = CreateWindow();
+        window->ReleaseCurrent();
+
+        std::atomic<int> errors(0);
+        window->OnError([&errors](error code, const std::string&) { errors += code == error::CONTEXT; });
+
+        std::atomic<bool> held(false);
+        std::atomic<bool> done(false);
+        std::thread holder = HoldContext(*window, held, done);
+
+        while (!held.load())
+            std::this_thread::yield();
+
+        CHECK(!window->StartRenderThread([]() {}));
+        CHECK(errors.load() == 1);
+
+        done.store(true);
+        holder.join();
+    }
+
+    return 0;
+}
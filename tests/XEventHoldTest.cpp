@@ -0,0 +1,90 @@
+#include "check.h"
+
+#include <vector>
+
+#include <XConnection.h>
+
+using namespace awml;
+
+static XEvent MakeEvent(int type, ::Window window, unsigned long serial)
+{
+    XEvent event = {};
+    event.type = type;
+    event.xany.window = window;
+    event.xany.serial = serial;
+
+    return event;
+}
+
+// Stands in for a window's event queue.
+struct FakeQueue
+{
+    size_t                     space;
+    std::vector<unsigned long> decoded;
+};
+
+int main()
+{
+    FakeQueue queues[2] = { { 0, {} }, { 8, {} } };
+
+    // Only compared, never dereferenced.
+    auto full = reinterpret_cast<XWindow*>(&queues[0]);
+    auto idle = reinterpret_cast<XWindow*>(&queues[1]);
+
+    auto decode = [](XWindow* window, const XEvent& event)
+    {
+        FakeQueue& queue = *reinterpret_cast<FakeQueue*>(window);
+
+        if (!queue.space)
+            return false;
+
+        --queue.space;
+        queue.decoded.push_back(event.xany.serial);
+        return true;
+    };
+
+    XEventRouter router;
+    router.Insert(0x400001, full);
+    router.Insert(0x600001, idle);
+
+    // The first window isn't polled, its events pile up
+    // without holding back the ones of the second.
+    CHECK(router.Deliver(MakeEvent(ConfigureNotify, 0x400001, 1), decode) == full);
+    CHECK(router.Deliver(MakeEvent(ConfigureNotify, 0x600001, 2), decode) == idle);
+    CHECK(router.Deliver(MakeEvent(ConfigureNotify, 0x400001, 3), decode) == full);
+    CHECK(router.Deliver(MakeEvent(ConfigureNotify, 0x600001, 4), decode) == idle);
+
+    CHECK(router.HeldEvents(full) == 2);
+    CHECK(router.HeldEvents(idle) == 0);
+    CHECK((queues[1].decoded == std::vector<unsigned long> { 2, 4 }));
+
+    // Room for one, the rest stays held in order.
+    queues[0].space = 1;
+
+    CHECK(router.Release(full, decode) == 1);
+    CHECK(router.HeldEvents(full) == 1);
+
+    // A new event can't overtake the held one.
+    queues[0].space = 1;
+
+    CHECK(router.Deliver(MakeEvent(ConfigureNotify, 0x400001, 5), decode) == full);
+    CHECK(router.HeldEvents(full) == 2);
+    CHECK(queues[0].space == 1);
+
+    queues[0].space = 8;
+
+    CHECK(router.Release(full, decode) == 2);
+    CHECK(router.HeldEvents(full) == 0);
+    CHECK((queues[0].decoded == std::vector<unsigned long> { 1, 3, 5 }));
+
+    // Held events of a closed window go with it.
+    queues[0].space = 0;
+
+    router.Deliver(MakeEvent(ConfigureNotify, 0x400001, 6), decode);
+    CHECK(router.HeldEvents(full) == 1);
+
+    router.Erase(0x400001);
+    CHECK(router.HeldEvents(full) == 0);
+
+    return 0;
+}
@@ -0,0 +1,56 @@
+#include "check.h"
+
+#include <XConnection.h>
+
+using namespace awml;
+
+static XEvent MakeEvent(int type, ::Window window)
+{
+    XEvent event = {};
+    event.type = type;
+    event.xany.window = window;
+
+    return event;
+}
+
+int main()
+{
+    // Only compared, never dereferenced.
+    char storage[2];
+    auto first  = reinterpret_cast<XWindow*>(&storage[0]);
+    auto second = reinterpret_cast<XWindow*>(&storage[1]);
+
+    XEventRouter router;
+    router.Insert(0x400001, first);
+    router.Insert(0x600001, second);
+
+    // Xlib always leaves the window of KeymapNotify None.
+    XEvent keymap = MakeEvent(KeymapNotify, None);
+
+    CHECK(router.Route(keymap) == nullptr);
+
+    // Focus moves from the second window to the first, the key
+    // state that follows belongs to the window gaining focus.
+    CHECK(router.Route(MakeEvent(FocusOut, 0x600001)) == second);
+    CHECK(router.Route(MakeEvent(FocusIn, 0x400001)) == first);
+    CHECK(router.Route(keymap) == first);
+
+    CHECK(router.Route(MakeEvent(FocusOut, 0x400001)) == first);
+    CHECK(router.Route(MakeEvent(FocusIn, 0x600001)) == second);
+    CHECK(router.Route(keymap) == second);
+
+    // Other events don't move the target.
+    CHECK(router.Route(MakeEvent(ConfigureNotify, 0x400001)) == first);
+    CHECK(router.Route(keymap) == second);
+
+    // A closed window is no target anymore.
+    router.Erase(0x600001);
+
+    CHECK(router.Route(MakeEvent(FocusIn, 0x600001)) == nullptr);
+    CHECK(router.Route(keymap) == nullptr);
+
+    CHECK(router.Route(MakeEvent(EnterNotify, 0x400001)) == first);
+    CHECK(router.Route(keymap) == first);
+
+    return 0;
+}
@@ -0,0 +1,41 @@
+#include "check.h"
+
+#include <XWindow.h>
+
+using namespace awml;
+
+int main()
+{
+    // Never launched, the mask is tracked all the same.
+    XWindow window(L"Test", 640, 480, Context::NONE, WindowMode::WINDOWED, CursorMode::VISIBLE, false);
+
+    window.OnWindowResized([](uint16_t, uint16_t) {});
+
+    // A callback only app gets nothing it didn't ask for.
+    CHECK(window.GetSelectedInput() == (StructureNotifyMask | FocusChangeMask | KeymapStateMask));
+
+    window.OnMousePressed([](awml_key) {});
+
+    CHECK(window.GetSelectedInput() & ButtonPressMask);
+    CHECK(!(window.GetSelectedInput() & KeyPressMask));
+    CHECK(!(window.GetSelectedInput() & PointerMotionMask));
+
+    // Key state queries need the key and button events from then on.
+    CHECK(!window.IsKeyPressed(awml_key::A));
+    CHECK(window.GetSelectedInput() & KeyPressMask);
+    CHECK(window.GetSelectedInput() & KeyReleaseMask);
+    CHECK(!(window.GetSelectedInput() & PointerMotionMask));
+
+    window.GetMouseX();
+    CHECK(window.GetSelectedInput() & PointerMotionMask);
+
+    XWindow queue(L"Test", 640, 480, Context::NONE, WindowMode::WINDOWED, CursorMode::VISIBLE, false);
+
+    queue.SelectEvents(EventBit(EventType::MOUSE_MOVED));
+    CHECK(queue.GetSelectedInput() == (StructureNotifyMask | FocusChangeMask | KeymapStateMask | PointerMotionMask));
+
+    queue.SelectEvents(0);
+    CHECK(!(queue.GetSelectedInput() & PointerMotionMask));
+
+    return 0;
+}
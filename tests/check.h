@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+// Fails the test with the expression and its location, the
+// tests are plain executables run by ctest.
+#define CHECK(expression)                                                   \
+    do                                                                      \
+    {                                                                       \
+        if (!(expression))                                                  \
+        {                                                                   \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n",               \
+                         __FILE__, __LINE__, #expression);                  \
+            std::exit(EXIT_FAILURE);                                        \
+        }                                                                   \
+    } while (false)